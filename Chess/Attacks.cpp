@@ -3,6 +3,8 @@
 #include <chrono>
 #include <random>
 
+#include "LargePages.h"
+
 using namespace SimpleChessEngine;
 
 template <Piece sliding_piece>
@@ -73,14 +75,23 @@ const std::unique_ptr<AttackTable<sliding_piece>>
         std::make_unique<AttackTable>();
 
 namespace {
-std::array<Bitboard, 88772> shared_table;
+/**
+ * \brief Gets the table of attack maps shared by bishops and rooks.
+ *
+ * \details Allocated on first use, so it does not depend on the order of
+ * initialization of static members.
+ */
+Bitboard* GetSharedTable() {
+  static const LargePageArray<Bitboard> shared_table(88772);
+  return shared_table.data();
 }
+}  // namespace
 
 template <Piece sliding_piece>
 AttackTable<sliding_piece>::AttackTable() {
   if constexpr (!IsWeakSlidingPiece(sliding_piece)) return;
 
-  table_ = shared_table.data();
+  table_ = GetSharedTable();
 
   if constexpr (sliding_piece == Piece::kBishop) {
     magic_ = {
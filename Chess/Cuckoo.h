@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <utility>
+
+#include "Attacks.h"
+#include "Hasher.h"
+#include "Move.h"
+
+namespace SimpleChessEngine {
+/**
+ * \brief Cuckoo hash table of all reversible moves on an empty board.
+ *
+ * \details A move is stored under the difference of hashes of the positions
+ * before and after it. The difference of hashes of two positions of the
+ * game finds a move that connects them in at most two probes.
+ */
+constexpr size_t kCuckooSize = 8192;
+
+inline std::array<Hash, kCuckooSize> cuckoo_keys{};
+inline std::array<Move, kCuckooSize> cuckoo_moves{};
+
+[[nodiscard]] constexpr size_t CuckooFirstIndex(const Hash key) {
+  return key & (kCuckooSize - 1);
+}
+
+[[nodiscard]] constexpr size_t CuckooSecondIndex(const Hash key) {
+  return (key >> 16) & (kCuckooSize - 1);
+}
+
+[[nodiscard]] inline Bitboard GetEmptyBoardAttacks(const Piece piece,
+                                                   const BitIndex square) {
+  switch (piece) {
+    case Piece::kKnight:
+      return AttackTable<Piece::kKnight>::GetAttackMap(square, kEmptyBoard);
+    case Piece::kBishop:
+      return AttackTable<Piece::kBishop>::GetAttackMap(square, kEmptyBoard);
+    case Piece::kRook:
+      return AttackTable<Piece::kRook>::GetAttackMap(square, kEmptyBoard);
+    case Piece::kQueen:
+      return AttackTable<Piece::kQueen>::GetAttackMap(square, kEmptyBoard);
+    case Piece::kKing:
+      return AttackTable<Piece::kKing>::GetAttackMap(square, kEmptyBoard);
+    default:
+      return kEmptyBoard;
+  }
+}
+
+inline void InitCuckoo() {
+  cuckoo_keys.fill(0);
+  cuckoo_moves.fill(Move{});
+
+  [[maybe_unused]] size_t count = 0;
+  for (const auto color : {Player::kWhite, Player::kBlack}) {
+    const auto color_idx = static_cast<size_t>(color);
+    for (const auto piece : {Piece::kKnight, Piece::kBishop, Piece::kRook,
+                             Piece::kQueen, Piece::kKing}) {
+      const auto& psqt_hash = kHasher.psqt_hash[static_cast<size_t>(piece)];
+      for (size_t from = 0; from < kBoardArea; ++from) {
+        for (size_t to = from + 1; to < kBoardArea; ++to) {
+          if (!GetEmptyBoardAttacks(piece, static_cast<BitIndex>(from))
+                   .Test(static_cast<BitIndex>(to))) {
+            continue;
+          }
+
+          auto move =
+              Move{static_cast<BitIndex>(from), static_cast<BitIndex>(to)};
+          auto key = psqt_hash[color_idx][from] ^ psqt_hash[color_idx][to] ^
+                     kHasher.stm_hash;
+          // push entries out until an empty slot is found
+          auto index = CuckooFirstIndex(key);
+          for (;;) {
+            std::swap(cuckoo_keys[index], key);
+            std::swap(cuckoo_moves[index], move);
+            if (move == Move{}) {
+              break;
+            }
+            index = index == CuckooFirstIndex(key) ? CuckooSecondIndex(key)
+                                                   : CuckooFirstIndex(key);
+          }
+          ++count;
+        }
+      }
+    }
+  }
+  assert(count == 3668);
+}
+}  // namespace SimpleChessEngine
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "Position.h"
 
 namespace SimpleChessEngine
@@ -26,7 +28,7 @@ namespace SimpleChessEngine
       evaluation_data_.material[us_idx] - evaluation_data_.material[them_idx];
   result += evaluation_data_.psqt[us_idx] - evaluation_data_.psqt[them_idx];
 
-  const Eval tapered = result(evaluation_data_.non_pawn_material);
+  const Eval tapered = result(GetNonPawnMaterial());
 
   return tapered + kTempoBonus;
 }
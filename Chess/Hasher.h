@@ -1,7 +1,6 @@
 #pragma once
-#include <algorithm>
 #include <array>
-#include <random>
+#include <cstdint>
 
 #include "Utility.h"
 
@@ -11,33 +10,56 @@ class Position;
 
 using Hash = unsigned long long;
 
+/**
+ * \brief Zobrist keys of the position features.
+ *
+ * \details Keys are generated at compile time by SplitMix64, so they are
+ * the same in every build and positions do not carry their own copy.
+ */
 struct Hasher
 {
-  template <class RNG>
-  explicit Hasher(RNG generator)
+  constexpr explicit Hasher(uint64_t seed)
   {
-    auto generator_reference = std::reference_wrapper(generator);
-    for (auto& piece_type: psqt_hash)
+    const auto generator = [&seed]
     {
-      for (auto& colored_board: piece_type)
+      seed += 0x9e3779b97f4a7c15;
+      auto result = seed;
+      result = (result ^ result >> 30) * 0xbf58476d1ce4e5b9;
+      result = (result ^ result >> 27) * 0x94d049bb133111eb;
+      return static_cast<Hash>(result ^ result >> 31);
+    };
+    for (auto& piece_type : psqt_hash)
+    {
+      for (auto& colored_board : piece_type)
       {
-        std::generate(colored_board.begin(), colored_board.end(), generator_reference);
+        for (auto& key : colored_board)
+        {
+          key = generator();
+        }
       }
     }
-    std::generate(en_croissant_hash.begin(), en_croissant_hash.end(),
-                  generator_reference);
+    for (auto& key : en_croissant_hash)
+    {
+      key = generator();
+    }
     for (auto& color : cr_hash)
     {
-      std::generate(color.begin(), color.end(), generator_reference);
+      for (auto& key : color)
+      {
+        key = generator();
+      }
     }
-    stm_hash = generator_reference();
+    stm_hash = generator();
   }
 
   bool operator==(const Hasher&) const = default;
 
-  std::array<std::array<std::array<Hash, kBoardArea>, kColors>, kPieceTypes> psqt_hash{};
+  std::array<std::array<std::array<Hash, kBoardArea>, kColors>, kPieceTypes>
+      psqt_hash{};
   std::array<Hash, kLineSize> en_croissant_hash{};
   std::array<std::array<Hash, 4>, kColors> cr_hash{};
-  Hash stm_hash;
+  Hash stm_hash{};
 };
+
+inline constexpr Hasher kHasher{0xb00b1e5};
 }  // namespace SimpleChessEngine
@@ -0,0 +1,156 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace SimpleChessEngine {
+/**
+ * \brief Kind of memory pages an allocation is backed by.
+ */
+enum class PageKind : uint8_t {
+  kDefault,  //!< Ordinary pages of the operating system.
+  kHuge      //!< Huge (large) pages.
+};
+
+/**
+ * \brief Array of trivially destructible objects placed in huge pages.
+ *
+ * \details Huge pages reduce TLB misses on big tables that are accessed
+ * randomly. On Linux the memory is aligned to 2 MB and transparent huge pages
+ * are requested with madvise, they are reported only if the kernel has them
+ * enabled. On Windows large pages are used if the process has the privilege.
+ * Otherwise ordinary pages are used.
+ *
+ * \tparam T Type of the objects.
+ */
+template <class T>
+class LargePageArray {
+  static_assert(std::is_trivially_destructible_v<T>);
+
+ public:
+  static constexpr std::size_t kHugePageSize = 2 * 1024 * 1024;
+
+  LargePageArray() = default;
+
+  explicit LargePageArray(const std::size_t size) : size_(size) {
+    Allocate(size * sizeof(T));
+    std::uninitialized_value_construct_n(data_, size_);
+  }
+
+  LargePageArray(const LargePageArray&) = delete;
+  LargePageArray& operator=(const LargePageArray&) = delete;
+
+  LargePageArray(LargePageArray&& other) noexcept { Swap(other); }
+
+  LargePageArray& operator=(LargePageArray&& other) noexcept {
+    LargePageArray{std::move(other)}.Swap(*this);
+    return *this;
+  }
+
+  ~LargePageArray() { Free(); }
+
+  [[nodiscard]] T* data() const { return data_; }
+  [[nodiscard]] std::size_t size() const { return size_; }
+
+  [[nodiscard]] T* begin() const { return data_; }
+  [[nodiscard]] T* end() const { return data_ + size_; }
+
+  [[nodiscard]] T& operator[](const std::size_t index) const {
+    return data_[index];
+  }
+
+  [[nodiscard]] PageKind GetPageKind() const { return page_kind_; }
+
+ private:
+  void Swap(LargePageArray& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(page_kind_, other.page_kind_);
+  }
+
+  void Allocate(std::size_t bytes) {
+#ifdef _WIN32
+    if (const auto large_page_size = GetLargePageMinimum()) {
+      const auto large_bytes =
+          (bytes + large_page_size - 1) / large_page_size * large_page_size;
+      data_ = static_cast<T*>(
+          VirtualAlloc(nullptr, large_bytes,
+                       MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                       PAGE_READWRITE));
+      if (data_) {
+        page_kind_ = PageKind::kHuge;
+        return;
+      }
+    }
+    data_ = static_cast<T*>(VirtualAlloc(
+        nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    bytes = (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    data_ = static_cast<T*>(std::aligned_alloc(kHugePageSize, bytes));
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    // madvise succeeds even if the kernel never gives huge pages
+    if (data_ && !madvise(data_, bytes, MADV_HUGEPAGE) &&
+        AreTransparentHugePagesEnabled()) {
+      page_kind_ = PageKind::kHuge;
+    }
+#endif
+#endif
+    if (!data_) {
+      throw std::bad_alloc{};
+    }
+  }
+
+#ifdef __linux__
+  /**
+   * \brief Checks that the kernel backs advised memory with huge pages.
+   *
+   * \details The active mode in the setting is bracketed, for example
+   * "always [madvise] never".
+   */
+  [[nodiscard]] static bool AreTransparentHugePagesEnabled() {
+    static const bool enabled = [] {
+      std::ifstream setting("/sys/kernel/mm/transparent_hugepage/enabled");
+      std::string modes;
+      std::getline(setting, modes);
+      return modes.find("[always]") != std::string::npos ||
+             modes.find("[madvise]") != std::string::npos;
+    }();
+    return enabled;
+  }
+#endif
+
+  void Free() {
+    if (!data_) {
+      return;
+    }
+#ifdef _WIN32
+    VirtualFree(data_, 0, MEM_RELEASE);
+#else
+    std::free(data_);
+#endif
+    data_ = nullptr;
+  }
+
+  T* data_ = nullptr;
+  std::size_t size_ = 0;
+  PageKind page_kind_ = PageKind::kDefault;
+};
+}  // namespace SimpleChessEngine
@@ -1,121 +1,115 @@
 #pragma once
+#include <cassert>
 #include <cstdint>
-#include <tuple>
-#include <variant>
 
 #include "BitBoard.h"
 #include "Piece.h"
 namespace SimpleChessEngine
 {
-struct DefaultMove
+enum class CastlingSide : uint8_t
 {
-  bool operator==(const DefaultMove&) const = default;
-
-  BitIndex from{};
-  BitIndex to{};
-  Piece captured_piece{};
-};
-
-struct PawnPush
-{
-  bool operator==(const PawnPush&) const = default;
-
-  BitIndex from{};
-  BitIndex to{};
+  k00,
+  k000
 };
 
-struct DoublePush
+/**
+ * \brief Kind of a move.
+ */
+enum class MoveType : uint8_t
 {
-  bool operator==(const DoublePush&) const = default;
-
-  BitIndex from{};
-  BitIndex to{};
-};
-
-struct EnCroissant
-{
-  BitIndex from{};
-  BitIndex to{};
-
-  bool operator==(const EnCroissant&) const = default;
+  kDefault,      //!< Quiet move or capture, including single pawn pushes.
+  kDoublePush,   //!< Pawn push by two squares.
+  kEnCroissant,  //!< En passant capture.
+  kCastling,     //!< Castling, encoded as the king moving to its rook.
+  kPromotion     //!< Promotion, possibly with a capture.
 };
 
-struct Promotion : DefaultMove
+/**
+ * \brief Move packed into 16 bits.
+ *
+ * \details Bits 0-5 store the origin square, bits 6-11 store the destination
+ * square and the highest bits store the kind of the move. Promotions use the
+ * kinds from kPromotion on, one for each piece from knight to queen.
+ * The captured piece is not stored, it is on the board before the move.
+ */
+class Move
 {
-  bool operator==(const Promotion& other) const
+ public:
+  constexpr Move() = default;
+
+  constexpr Move(const BitIndex from, const BitIndex to,
+                 const MoveType type = MoveType::kDefault)
+      : data_(static_cast<uint16_t>(from | to << kSquareBits |
+                                    static_cast<uint8_t>(type)
+                                        << kTypeShift))
   {
-    return DefaultMove::operator==(other) && promoted_to == other.promoted_to;
+    assert(type != MoveType::kPromotion);
   }
 
-  Piece promoted_to{};
-};
-
-struct Castling
-{
-  enum class CastlingSide : uint8_t
+  constexpr Move(const BitIndex from, const BitIndex to,
+                 const Piece promoted_to)
+      : data_(static_cast<uint16_t>(
+            from | to << kSquareBits |
+            (static_cast<uint8_t>(MoveType::kPromotion) +
+             static_cast<uint8_t>(promoted_to) -
+             static_cast<uint8_t>(Piece::kKnight))
+                << kTypeShift))
   {
-    k00,
-    k000
-  };
-
-  CastlingSide side;
-
-  BitIndex king_from{};
-  BitIndex rook_from{};
+    assert(promoted_to >= Piece::kKnight && promoted_to <= Piece::kQueen);
+  }
 
-  bool operator==(const Castling&) const = default;
-};
+  /**
+   * \brief Restores a move from its packed form.
+   */
+  [[nodiscard]] static constexpr Move FromRaw(const uint16_t data)
+  {
+    Move move;
+    move.data_ = data;
+    return move;
+  }
 
-using Move = std::variant<PawnPush, DoublePush, EnCroissant, DefaultMove,
-                          Castling, Promotion>;
+  [[nodiscard]] constexpr uint16_t GetRaw() const { return data_; }
 
-inline std::tuple<BitIndex, BitIndex, Piece> GetMoveData(const PawnPush& move)
-{
-  return {move.from, move.to, Piece::kNone};
-}
-
-inline std::tuple<BitIndex, BitIndex, Piece> GetMoveData(const DoublePush& move)
-{
-  return {move.from, move.to, Piece::kNone};
-}
+  [[nodiscard]] constexpr BitIndex GetFrom() const
+  {
+    return static_cast<BitIndex>(data_ & kSquareMask);
+  }
 
-inline std::tuple<BitIndex, BitIndex, Piece> GetMoveData(
-    const EnCroissant& move)
-{
-  return {move.from, move.to, Piece::kPawn};
-}
+  [[nodiscard]] constexpr BitIndex GetTo() const
+  {
+    return static_cast<BitIndex>(data_ >> kSquareBits & kSquareMask);
+  }
 
-inline std::tuple<BitIndex, BitIndex, Piece> GetMoveData(
-    const DefaultMove& move)
-{
-  return {move.from, move.to, move.captured_piece};
-}
+  [[nodiscard]] constexpr MoveType GetType() const
+  {
+    const auto type = static_cast<uint8_t>(data_ >> kTypeShift);
+    return type < static_cast<uint8_t>(MoveType::kPromotion)
+               ? static_cast<MoveType>(type)
+               : MoveType::kPromotion;
+  }
 
-inline std::tuple<BitIndex, BitIndex, Piece> GetMoveData(const Castling& move)
-{
-  return {move.king_from, 64, Piece::kNone};
-}
+  [[nodiscard]] constexpr Piece GetPromotedTo() const
+  {
+    assert(GetType() == MoveType::kPromotion);
+    return static_cast<Piece>((data_ >> kTypeShift) -
+                              static_cast<uint8_t>(MoveType::kPromotion) +
+                              static_cast<uint8_t>(Piece::kKnight));
+  }
 
-inline std::tuple<BitIndex, BitIndex, Piece> GetMoveData(const Promotion& move)
-{
-  return {move.from, move.to, move.captured_piece};
-}
+  [[nodiscard]] constexpr CastlingSide GetCastlingSide() const
+  {
+    assert(GetType() == MoveType::kCastling);
+    return GetTo() > GetFrom() ? CastlingSide::k00 : CastlingSide::k000;
+  }
 
-inline std::tuple<BitIndex, BitIndex, Piece> GetMoveData(const Move& move)
-{
-  return std::visit([](const auto& unwrapped_move)
-                    { return GetMoveData(unwrapped_move); },
-                    move);
-}
+  constexpr bool operator==(const Move&) const = default;
 
-inline bool IsQuiet(const Move& move) {
-  return !std::get<Piece>(GetMoveData(move));
-}
+ private:
+  static constexpr uint8_t kSquareBits = 6;
+  static constexpr uint16_t kSquareMask = (1 << kSquareBits) - 1;
+  static constexpr uint8_t kTypeShift = 2 * kSquareBits;
 
-inline bool DoesReset(const Move& move) {
-  if (std::holds_alternative<DefaultMove>(move)) {
-    return !!std::get<DefaultMove>(move).captured_piece;
-  }
-  return !std::holds_alternative<Castling>(move);
-}
-}  // namespace SimpleChessEngine
\ No newline at end of file
+  uint16_t data_{};
+};
+static_assert(sizeof(Move) == sizeof(uint16_t));
+}  // namespace SimpleChessEngine
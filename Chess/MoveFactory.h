@@ -24,15 +24,18 @@ struct MoveFactory
 inline Move MoveFactory::operator()(const Position& position,
                                     const std::string& move) const
 {
+  const auto us = position.GetSideToMove();
   if (move == "O-O")
   {
-    return Castling{Castling::CastlingSide::k00,
-                    position.GetKingSquare(position.GetSideToMove())};
+    return Move{position.GetKingSquare(us),
+                position.GetCastlingRookSquare(us, CastlingSide::k00),
+                MoveType::kCastling};
   }
   if (move == "O-O-O")
   {
-    return Castling{Castling::CastlingSide::k000,
-                    position.GetKingSquare(position.GetSideToMove())};
+    return Move{position.GetKingSquare(us),
+                position.GetCastlingRookSquare(us, CastlingSide::k000),
+                MoveType::kCastling};
   }
 
   const auto [from, to] = ParseDefaultMove(move);
@@ -43,38 +46,32 @@ inline Move MoveFactory::operator()(const Position& position,
   {
     if (!IsAdjacent(from, to))
     {
-      static std::unordered_map<File, Castling::CastlingSide> castling_file = {
-          {2, Castling::CastlingSide::k000}, {6, Castling::CastlingSide::k00}};
-      static std::unordered_map<File, File> rook_from_file = {{1, 0}, {6, 7}};
-
-      auto [king_file, king_rank] = GetCoordinates(to);
-
-      return Castling{castling_file[king_file], from,
-                      GetSquare(rook_from_file[king_file], king_rank)};
+      const auto side = to > from ? CastlingSide::k00 : CastlingSide::k000;
+      return Move{from, position.GetCastlingRookSquare(us, side),
+                  MoveType::kCastling};
     }
   }
   if (constexpr size_t kPromotionSize = 5; move.size() == kPromotionSize)
   {
-    return Promotion{{from, to, position.GetPiece(to)},
-                     kPieces[move.back()].first};
+    return Move{from, to, kPieces[move.back()].first};
   }
 
   if (piece_to_move != Piece::kPawn)
   {
-    return DefaultMove{from, to, position.GetPiece(to)};
+    return Move{from, to};
   }
 
   if (!IsAdjacent(from, to))
   {
-    return DoublePush{from, to};
+    return Move{from, to, MoveType::kDoublePush};
   }
 
   if (to == position.GetEnCroissantSquare())
   {
-    return EnCroissant{from, to};
+    return Move{from, to, MoveType::kEnCroissant};
   }
 
-  return DefaultMove{from, to, position.GetPiece(to)};
+  return Move{from, to};
 }
 
 inline MoveFactory::ParsedMove MoveFactory::ParseDefaultMove(
@@ -3,54 +3,91 @@
 #include <cassert>
 
 namespace SimpleChessEngine {
-[[nodiscard]] bool MoveGenerator::IsPawnMoveLegal(Position& position,
-                                                  const Move& move) {
+void MoveGenerator::GenerateEvasions(Moves& moves,
+                                     const Position& position) const {
   const auto us = position.GetSideToMove();
+  const auto king_square = position.GetKingSquare(us);
+  const auto checkers = position.GetCheckers();
+  assert(checkers.Any());
 
-  if (std::holds_alternative<EnCroissant>(move)) {
-    const auto irreversible_data = position.GetIrreversibleData();
-    position.DoMove(move);
-    const auto valid = !position.IsUnderCheck(us);
-    position.UndoMove(move, irreversible_data);
-    return valid;
-  }
-
-  BitIndex from{};
-  BitIndex to{};
-  std::visit(
-      [&from, &to]<typename MoveType>(const MoveType& unwrapped_move) {
-        if constexpr (std::same_as<std::remove_cvref_t<MoveType>,
-                                   DefaultMove> ||
-                      std::same_as<std::remove_cvref_t<MoveType>, PawnPush> ||
-                      std::same_as<std::remove_cvref_t<MoveType>, DoublePush> ||
-                      std::same_as<std::remove_cvref_t<MoveType>, Promotion>) {
-          from = unwrapped_move.from;
-          to = unwrapped_move.to;
-          return;
-        }
-        assert(false);
-      },
-      move);
-  return !position.GetIrreversibleData().blockers[static_cast<size_t>(us)].Test(
-             from) ||
-         Ray(position.GetKingSquare(us), from).Test(to);
+  // the king does not block the ray of a slider it steps away from
+  const auto king = GetBitboardOfSquare(king_square);
+  auto king_moves = AttackTable<Piece::kKing>::GetAttackMap(king_square,
+                                                            kEmptyBoard) &
+                    ~position.GetPieces(us);
+  while (king_moves.Any()) {
+    const auto to = king_moves.PopFirstBit();
+    if (!position.IsUnderAttack(to, us, king)) {
+      moves.emplace_back(king_square, to);
+    }
+  }
+
+  if (checkers.MoreThanOne()) {
+    return;
+  }
+
+  const auto checker = checkers.GetFirstBit();
+  const auto target = Between(king_square, checker) | checkers;
+
+  GenerateMovesForPiece<Piece::kPawn>(moves, position, target);
+
+  // only the pawn that has just made a double push can be taken en passant
+  if (position.GetPiece(checker) == Piece::kPawn) {
+    GenerateEnCroissant(moves, position);
+  }
+
+  // a pinned piece leaves the ray of its pin to capture or block
+  const auto pieces = position.GetPieces(us) &
+                      ~position.GetPiecesByType<Piece::kPawn>(us) & ~king &
+                      ~position.GetBlockers(us);
+  auto squares = target;
+  while (squares.Any()) {
+    const auto to = squares.PopFirstBit();
+    auto defenders = position.Attackers(to) & pieces;
+    while (defenders.Any()) {
+      moves.emplace_back(defenders.PopFirstBit(), to);
+    }
+  }
 }
 
-void MoveGenerator::GenerateCastling(Moves& moves, const Position& position) {
-  if (position.IsUnderCheck()) {
+void MoveGenerator::GenerateEnCroissant(Moves& moves,
+                                        const Position& position) {
+  const auto en_croissant_square = position.GetEnCroissantSquare();
+  if (!en_croissant_square) {
     return;
   }
 
+  const auto us = position.GetSideToMove();
+  const auto to = en_croissant_square.value();
+
+  // our pawns that attack the square are those attacked from it by their pawn
+  auto attackers = GetPawnAttacks(to, Flip(us)) &
+                   position.GetPiecesByType<Piece::kPawn>(us);
+  while (attackers.Any()) {
+    const Move move{attackers.PopFirstBit(), to, MoveType::kEnCroissant};
+    // two pawns leave the rank at once, so pins are not enough to check it
+    if (position.IsLegal(move)) {
+      moves.push_back(move);
+    }
+  }
+}
+
+void MoveGenerator::GenerateCastling(Moves& moves, const Position& position,
+                                     const Bitboard attacked) {
   const auto side_to_move = position.GetSideToMove();
 
   const auto king_square = position.GetKingSquare(side_to_move);
 
+  if (attacked.Test(king_square)) {
+    return;
+  }
+
   for (const auto castling_side :
-       {Castling::CastlingSide::k00, Castling::CastlingSide::k000}) {
-    if (position.CanCastle(castling_side)) {
+       {CastlingSide::k00, CastlingSide::k000}) {
+    if (position.CanCastle(castling_side, attacked)) {
       const auto rook_square =
           position.GetCastlingRookSquare(side_to_move, castling_side);
-      moves.emplace_back(Castling{castling_side, king_square, rook_square});
+      moves.emplace_back(king_square, rook_square, MoveType::kCastling);
     }
   }
 }
@@ -1,9 +1,9 @@
 #pragma once
 
 #include <cstdint>
-#include <vector>
 
 #include "Move.h"
+#include "MoveList.h"
 #include "Position.h"
 #include "Utility.h"
 
@@ -15,12 +15,21 @@ namespace SimpleChessEngine {
  */
 class MoveGenerator {
  public:
-  enum class Type : uint8_t { kDefault, kQuiescence };
-
-  inline static constexpr size_t kMaxMovesPerPosition = 218;
-  MoveGenerator() { moves_.reserve(kMaxMovesPerPosition); }
+  /**
+   * \brief Kind of generated moves.
+   *
+   * \details Moves of kQuiescence and kQuiet never overlap and together they
+   * are exactly the moves of kDefault. In check kEvasions gives the same
+   * moves as kDefault, but only looks at the few squares that matter.
+   */
+  enum class Type : uint8_t {
+    kDefault,     //!< All legal moves.
+    kQuiescence,  //!< Captures, en passant and promotions.
+    kQuiet,       //!< Other moves: no capture and no promotion.
+    kEvasions     //!< All legal moves of a side in check.
+  };
 
-  using Moves = std::vector<Move>;
+  using Moves = MoveList;
 
   /**
    * \brief Generates all possible moves for a given position.
@@ -30,11 +39,28 @@ class MoveGenerator {
    * \return All possible moves for the given position.
    */
   template <Type type>
-  [[nodiscard]] Moves GenerateMoves(Position& position) const;
+  [[nodiscard]] Moves GenerateMoves(const Position& position) const;
+
+  /**
+   * \brief Generates all possible moves for a given position.
+   *
+   * \param position The position.
+   * \param moves Container where to add possible moves.
+   */
+  template <Type type>
+  void GenerateMoves(const Position& position, Moves& moves) const;
 
  private:
-  [[nodiscard]] static bool IsPawnMoveLegal(Position& position,
-                                            const Move& move);
+  /**
+   * \brief Generates moves of the given pawns, except en passant.
+   *
+   * \param moves Container where to add moves.
+   * \param position The position.
+   * \param pawns Pawns of the side to move.
+   * \param target Target squares.
+   */
+  static void GeneratePawnMoves(Moves& moves, const Position& position,
+                                Bitboard pawns, Bitboard target);
 
   /**
    * \brief Generates all possible moves for a given square.
@@ -46,7 +72,7 @@ class MoveGenerator {
    * \return All possible moves for the given square.
    */
   template <Piece piece>
-  void GenerateMovesForPiece(Moves& moves, Position& position,
+  void GenerateMovesForPiece(Moves& moves, const Position& position,
                              Bitboard target) const;
 
   /**
@@ -61,45 +87,72 @@ class MoveGenerator {
    * \return All possible moves for the given square and piece.
    */
   template <Piece piece>
-  void GenerateMovesFromSquare(Moves& moves, Position& position, BitIndex from,
-                               Bitboard target) const;
+  void GenerateMovesFromSquare(Moves& moves, const Position& position,
+                               BitIndex from, Bitboard target) const;
+
+  /**
+   * \brief Generates all moves out of check.
+   *
+   * \details The king steps to squares that are not attacked, other pieces
+   * capture or block the single checker. Pinned pieces can do neither.
+   *
+   * \param moves Container where to add moves.
+   * \param position The position, its side to move must be in check.
+   */
+  void GenerateEvasions(Moves& moves, const Position& position) const;
 
-  static void GenerateCastling(Moves& moves, const Position& position);
+  static void GenerateEnCroissant(Moves& moves, const Position& position);
 
-  mutable Moves moves_;
+  static void GenerateCastling(Moves& moves, const Position& position,
+                               Bitboard attacked);
 };
 
 template <MoveGenerator::Type type>
-MoveGenerator::Moves MoveGenerator::GenerateMoves(Position& position) const {
-  moves_.clear();
+MoveGenerator::Moves MoveGenerator::GenerateMoves(
+    const Position& position) const {
+  // the only returned object, so it is constructed in place of the result
+  Moves moves;
+  GenerateMoves<type>(position, moves);
+  return moves;
+}
+
+template <MoveGenerator::Type type>
+void MoveGenerator::GenerateMoves(const Position& position,
+                                  Moves& moves) const {
+  if constexpr (type == Type::kEvasions) {
+    GenerateEvasions(moves, position);
+    return;
+  }
 
   const auto us = position.GetSideToMove();
-  const auto them = Flip(us);
 
   auto target = ~position.GetPieces(us);
 
   if constexpr (type == Type::kQuiescence) {
     target &= position.GetPieces(Flip(us));
+  } else if constexpr (type == Type::kQuiet) {
+    target &= ~position.GetAllPieces();
   }
 
   const auto king_square = position.GetKingSquare(us);
-  const auto king_attacker =
-      position.Attackers(king_square) & position.GetPieces(them);
+  const auto king_attacker = position.GetCheckers();
+
+  // the king never goes to an attacked square
+  const auto attacked = position.GetEnemyAttacks();
+  const auto king_target = target & ~attacked;
 
   // Double-check check
   if (king_attacker.MoreThanOne()) {
-    GenerateMovesForPiece<Piece::kKing>(moves_, position, target);
-    return moves_;
+    GenerateMovesForPiece<Piece::kKing>(moves, position, king_target);
+    return;
   }
 
-  // compute pins
-  position.ComputePins(us);
-
-  const auto king_target = target;
   auto pawn_target = target;
 
   if constexpr (type == Type::kQuiescence) {
     pawn_target |= (kRankBB[0] | kRankBB[7]);
+  } else if constexpr (type == Type::kQuiet) {
+    pawn_target &= ~(kRankBB[0] | kRankBB[7]);
   }
   // is in check
   if (king_attacker.Any()) {
@@ -110,27 +163,27 @@ MoveGenerator::Moves MoveGenerator::GenerateMoves(Position& position) const {
     pawn_target &= ray;
   }
 
-  GenerateMovesForPiece<Piece::kPawn>(moves_, position, pawn_target);
+  GenerateMovesForPiece<Piece::kPawn>(moves, position, pawn_target);
 
-  std::erase_if(moves_, [&position](const Move& move) {
-    return !IsPawnMoveLegal(position, move);
-  });
+  if constexpr (type != Type::kQuiet) {
+    GenerateEnCroissant(moves, position);
+  }
 
   // generate moves for piece
-  GenerateMovesForPiece<Piece::kKing>(moves_, position, king_target);
-  GenerateMovesForPiece<Piece::kKnight>(moves_, position, target);
-  GenerateMovesForPiece<Piece::kBishop>(moves_, position, target);
-  GenerateMovesForPiece<Piece::kRook>(moves_, position, target);
-  GenerateMovesForPiece<Piece::kQueen>(moves_, position, target);
-
-  GenerateCastling(moves_, position);
-
-  // return moves
-  return moves_;
+  GenerateMovesForPiece<Piece::kKing>(moves, position, king_target);
+  GenerateMovesForPiece<Piece::kKnight>(moves, position, target);
+  GenerateMovesForPiece<Piece::kBishop>(moves, position, target);
+  GenerateMovesForPiece<Piece::kRook>(moves, position, target);
+  GenerateMovesForPiece<Piece::kQueen>(moves, position, target);
+
+  if constexpr (type != Type::kQuiescence) {
+    GenerateCastling(moves, position, attacked);
+  }
 }
 
 template <Piece piece>
-void MoveGenerator::GenerateMovesForPiece(Moves& moves, Position& position,
+void MoveGenerator::GenerateMovesForPiece(Moves& moves,
+                                          const Position& position,
                                           const Bitboard target) const {
   static_assert(piece != Piece::kPawn && piece != Piece::kKing);
 
@@ -145,13 +198,33 @@ void MoveGenerator::GenerateMovesForPiece(Moves& moves, Position& position,
 
 template <>
 inline void MoveGenerator::GenerateMovesForPiece<Piece::kPawn>(
-    Moves& moves, Position& position, const Bitboard target) const {
+    Moves& moves, const Position& position, const Bitboard target) const {
+  const auto us = position.GetSideToMove();
+  const auto king_square = position.GetKingSquare(us);
+
+  const auto pawns = position.GetPiecesByType<Piece::kPawn>(us);
+  const auto pinned = position.GetBlockers(us) & pawns;
+
+  GeneratePawnMoves(moves, position, pawns & ~pinned, target);
+
+  // a pinned pawn can only move along the pin
+  auto pinned_pawns = pinned;
+  while (pinned_pawns.Any()) {
+    const auto from = pinned_pawns.PopFirstBit();
+    GeneratePawnMoves(moves, position, GetBitboardOfSquare(from),
+                      target & Ray(king_square, from));
+  }
+}
+
+inline void MoveGenerator::GeneratePawnMoves(Moves& moves,
+                                             const Position& position,
+                                             const Bitboard pawns,
+                                             const Bitboard target) {
   const auto us = position.GetSideToMove();
   const auto us_idx = static_cast<size_t>(us);
   const auto them = Flip(us);
   const auto them_idx = static_cast<size_t>(them);
 
-  const auto pawns = position.GetPiecesByType<Piece::kPawn>(us);
   const auto promotion_rank = us == Player::kWhite ? kRankBB[6] : kRankBB[1];
   const auto direction = kPawnMoveDirection[us_idx];
   const auto opposite_direction = kPawnMoveDirection[them_idx];
@@ -172,7 +245,7 @@ inline void MoveGenerator::GenerateMovesForPiece<Piece::kPawn>(
 
     const auto from = Shift(to, opposite_direction);
 
-    moves.emplace_back(PawnPush{from, to});
+    moves.emplace_back(from, to);
   }
 
   auto double_push = Shift(double_push_pawns, direction) & valid_squares;
@@ -183,7 +256,7 @@ inline void MoveGenerator::GenerateMovesForPiece<Piece::kPawn>(
 
     const auto from = Shift(Shift(to, opposite_direction), opposite_direction);
 
-    moves.emplace_back(DoublePush{from, to});
+    moves.emplace_back(from, to, MoveType::kDoublePush);
   }
 
   static constexpr std::array cant_attack_files = {kFileBB[0], kFileBB[7]};
@@ -200,8 +273,6 @@ inline void MoveGenerator::GenerateMovesForPiece<Piece::kPawn>(
 
   const auto enemy_pieces = position.GetPieces(them);
 
-  const auto en_croissant_square = position.GetEnCroissantSquare();
-
   const std::array attacks_to = {
       Shift(non_promoting_pawns & ~cant_attack_files.front(), attacks.front()),
       Shift(non_promoting_pawns & ~cant_attack_files.back(), attacks.back())};
@@ -215,21 +286,7 @@ inline void MoveGenerator::GenerateMovesForPiece<Piece::kPawn>(
 
       const auto from = Shift(to, opposite_attacks[attack_direction]);
 
-      moves.emplace_back(DefaultMove{from, to, position.GetPiece(to)});
-    }
-  }
-
-  if (en_croissant_square) {
-    const auto en_croissant_bitboard =
-        GetBitboardOfSquare(en_croissant_square.value());
-    for (size_t attack_direction = 0; attack_direction < attacks.size();
-         ++attack_direction) {
-      auto attack_to = attacks_to[attack_direction] & en_croissant_bitboard;
-      if (attack_to.Any()) {
-        const auto to = en_croissant_square.value();
-        moves.emplace_back(
-            EnCroissant{Shift(to, opposite_attacks[attack_direction]), to});
-      }
+      moves.emplace_back(from, to);
     }
   }
 
@@ -243,14 +300,10 @@ inline void MoveGenerator::GenerateMovesForPiece<Piece::kPawn>(
 
     const auto from = Shift(to, opposite_direction);
 
-    moves.emplace_back(
-        Promotion{{from, to, position.GetPiece(to)}, Piece::kQueen});
-    moves.emplace_back(
-        Promotion{{from, to, position.GetPiece(to)}, Piece::kKnight});
-    moves.emplace_back(
-        Promotion{{from, to, position.GetPiece(to)}, Piece::kRook});
-    moves.emplace_back(
-        Promotion{{from, to, position.GetPiece(to)}, Piece::kBishop});
+    moves.emplace_back(from, to, Piece::kQueen);
+    moves.emplace_back(from, to, Piece::kKnight);
+    moves.emplace_back(from, to, Piece::kRook);
+    moves.emplace_back(from, to, Piece::kBishop);
   }
 
   for (size_t attack_direction = 0; attack_direction < attacks.size();
@@ -265,65 +318,25 @@ inline void MoveGenerator::GenerateMovesForPiece<Piece::kPawn>(
 
       const auto from = Shift(to, opposite_attacks[attack_direction]);
 
-      moves.emplace_back(
-          Promotion{{from, to, position.GetPiece(to)}, Piece::kKnight});
-      moves.emplace_back(
-          Promotion{{from, to, position.GetPiece(to)}, Piece::kBishop});
-      moves.emplace_back(
-          Promotion{{from, to, position.GetPiece(to)}, Piece::kRook});
-      moves.emplace_back(
-          Promotion{{from, to, position.GetPiece(to)}, Piece::kQueen});
+      moves.emplace_back(from, to, Piece::kKnight);
+      moves.emplace_back(from, to, Piece::kBishop);
+      moves.emplace_back(from, to, Piece::kRook);
+      moves.emplace_back(from, to, Piece::kQueen);
     }
   }
 }
 
 template <>
 inline void MoveGenerator::GenerateMovesForPiece<Piece::kKing>(
-    Moves& moves, Position& position, Bitboard target) const {
-  const auto us = position.GetSideToMove();
-  const auto them = Flip(us);
-
-  const auto king_pos = position.GetKingSquare(us);
-  const auto king_mask = GetBitboardOfSquare(king_pos);
-
-  const auto occupancy = position.GetAllPieces() ^ king_mask;
-
-  // we prevent the king from going to squares attacked by enemy pieces
-
-  target &= ~position.GetAllPawnAttacks(Flip(us));
-
-  Bitboard attackers = position.GetPiecesByType<Piece::kKnight>(them);
-  while (attackers.Any()) {
-    target &= ~AttackTable<Piece::kKnight>::GetAttackMap(
-        attackers.PopFirstBit(), occupancy);
-  }
-
-  attackers = position.GetPiecesByType<Piece::kBishop>(them);
-  while (attackers.Any()) {
-    target &= ~AttackTable<Piece::kBishop>::GetAttackMap(
-        attackers.PopFirstBit(), occupancy);
-  }
-
-  attackers = position.GetPiecesByType<Piece::kRook>(them);
-  while (attackers.Any()) {
-    target &= ~AttackTable<Piece::kRook>::GetAttackMap(attackers.PopFirstBit(),
-                                                       occupancy);
-  }
-
-  attackers = position.GetPiecesByType<Piece::kQueen>(them);
-  while (attackers.Any()) {
-    target &= ~AttackTable<Piece::kQueen>::GetAttackMap(attackers.PopFirstBit(),
-                                                        occupancy);
-  }
-
-  target &= ~AttackTable<Piece::kKing>::GetAttackMap(
-      position.GetKingSquare(them), occupancy);
+    Moves& moves, const Position& position, const Bitboard target) const {
+  const auto king_pos = position.GetKingSquare(position.GetSideToMove());
 
   GenerateMovesFromSquare<Piece::kKing>(moves, position, king_pos, target);
 }
 
 template <Piece piece>
-void MoveGenerator::GenerateMovesFromSquare(Moves& moves, Position& position,
+void MoveGenerator::GenerateMovesFromSquare(Moves& moves,
+                                            const Position& position,
                                             const BitIndex from,
                                             Bitboard target) const {
   assert(position.GetPiece(from) == piece);
@@ -336,9 +349,7 @@ void MoveGenerator::GenerateMovesFromSquare(Moves& moves, Position& position,
   const auto side_to_move = position.GetSideToMove();
 
   // if the piece is pinned we can only move in pin direction
-  if (position.GetIrreversibleData()
-          .blockers[static_cast<size_t>(side_to_move)]
-          .Test(from)) {
+  if (position.GetBlockers(side_to_move).Test(from)) {
     target &= Ray(position.GetKingSquare(side_to_move), from);
   }
 
@@ -348,8 +359,7 @@ void MoveGenerator::GenerateMovesFromSquare(Moves& moves, Position& position,
   while (valid_moves.Any()) {
     const auto to = valid_moves.PopFirstBit();
 
-    const auto move = DefaultMove{from, to, position.GetPiece(to)};
-    moves.emplace_back(move);
+    moves.emplace_back(from, to);
   }
 }
 }  // namespace SimpleChessEngine
@@ -0,0 +1,83 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "Move.h"
+
+namespace SimpleChessEngine {
+constexpr std::size_t kMaxMovesPerPosition = 218;
+
+using MoveScore = int32_t;
+
+/**
+ * \brief List of moves with inline storage.
+ *
+ * \details Holds up to kMaxMovesPerPosition moves without any heap
+ * allocation, so it is cheap to create at every node of the search. Each move
+ * has a score slot for move ordering.
+ */
+class MoveList {
+ public:
+  using value_type = Move;
+  using iterator = Move*;
+  using const_iterator = const Move*;
+
+  template <class... Args>
+  Move& emplace_back(Args&&... args) {
+    assert(size_ < kMaxMovesPerPosition);
+    return moves_[size_++] = Move{std::forward<Args>(args)...};
+  }
+
+  void push_back(const Move move) { emplace_back(move); }
+
+  void clear() { size_ = 0; }
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  [[nodiscard]] iterator begin() { return moves_.data(); }
+  [[nodiscard]] iterator end() { return moves_.data() + size_; }
+  [[nodiscard]] const_iterator begin() const { return moves_.data(); }
+  [[nodiscard]] const_iterator end() const { return moves_.data() + size_; }
+
+  [[nodiscard]] Move& front() { return moves_.front(); }
+  [[nodiscard]] const Move& front() const { return moves_.front(); }
+
+  [[nodiscard]] Move& operator[](const std::size_t index) {
+    return moves_[index];
+  }
+  [[nodiscard]] const Move& operator[](const std::size_t index) const {
+    return moves_[index];
+  }
+
+  /**
+   * \brief Gets the score slot of the move.
+   *
+   * \param index Index of the move.
+   *
+   * \return Reference to the score of the move.
+   */
+  [[nodiscard]] MoveScore& GetScore(const std::size_t index) {
+    return scores_[index];
+  }
+  [[nodiscard]] MoveScore GetScore(const std::size_t index) const {
+    return scores_[index];
+  }
+
+  /**
+   * \brief Swaps two moves together with their scores.
+   */
+  void Swap(const std::size_t lhs, const std::size_t rhs) {
+    std::swap(moves_[lhs], moves_[rhs]);
+    std::swap(scores_[lhs], scores_[rhs]);
+  }
+
+ private:
+  std::size_t size_ = 0;
+  std::array<Move, kMaxMovesPerPosition> moves_;
+  std::array<MoveScore, kMaxMovesPerPosition> scores_;
+};
+}  // namespace SimpleChessEngine
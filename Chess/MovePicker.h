@@ -0,0 +1,282 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#include "KillerTable.h"
+#include "MoveGenerator.h"
+#include "MoveList.h"
+#include "Position.h"
+
+namespace SimpleChessEngine {
+/**
+ * \brief Gives moves of a position one by one in the order of search.
+ *
+ * \details Moves are produced in stages, so that a node that is cut off
+ * early never pays for generating and sorting all its moves:
+ *  - the move from the transposition table, without any generation;
+ *  - captures and promotions that do not lose material, best MVV-LVA first;
+ *  - killer moves;
+ *  - quiet moves, best history first;
+ *  - captures that lose material.
+ *
+ * Each stage picks the best remaining move instead of sorting the whole list.
+ * The hash move and killers are validated on the board, so they are tried
+ * before any generation. In check only evasions are generated, they are split
+ * into the same captures and quiets.
+ */
+class MovePicker {
+ public:
+  static constexpr std::size_t kKillerCount = 2;
+
+  using Killers = KillerTable<kKillerCount>;
+  using History = std::array<std::array<uint64_t, kBoardArea>, kBoardArea>;
+
+  enum class Stage : uint8_t {
+    kHashMove,
+    kGenerateCaptures,
+    kGoodCaptures,
+    kSelectKillers,
+    kKillers,
+    kGenerateQuiets,
+    kQuiets,
+    kBadCaptures,
+    kDone
+  };
+
+  /**
+   * \brief Constructor.
+   *
+   * \param position The position, it must not change while moves are picked.
+   * \param hash_move Move from the transposition table, if there is one.
+   * \param killers Killer moves of the search.
+   * \param ply Distance from the root of the search.
+   * \param history History of quiet moves of the side to move.
+   */
+  MovePicker(const Position& position, const std::optional<Move> hash_move,
+             const Killers& killers, const Depth ply, const History& history)
+      : position_(position),
+        hash_move_(hash_move),
+        killers_(killers),
+        ply_(ply),
+        history_(history) {}
+
+  /**
+   * \brief Gets the next move.
+   *
+   * \return The next move or nullopt if all moves were given.
+   */
+  [[nodiscard]] std::optional<Move> SelectNextMove();
+
+  /**
+   * \brief Checks if the move was given as a killer move.
+   */
+  [[nodiscard]] bool IsKiller(const Move& move) const;
+
+ private:
+  static constexpr MoveScore kBadCaptureScore = -(1 << 16);
+
+  [[nodiscard]] MoveScore ScoreCapture(const Move& move) const;
+
+  [[nodiscard]] MoveScore ScoreQuiet(const Move& move) const;
+
+  [[nodiscard]] bool IsPlayable(const Move& move) const;
+
+  /**
+   * \brief Generates evasions of the check into captures and quiets.
+   */
+  void GenerateEvasions();
+
+  /**
+   * \brief Moves the best of the moves from the index to the end to the index.
+   */
+  [[nodiscard]] static Move PickBest(MoveList& moves, std::size_t index,
+                                     std::size_t end);
+
+  const Position& position_;
+
+  std::optional<Move> hash_move_;
+  const Killers& killers_;
+  Depth ply_;
+  const History& history_;
+
+  Stage stage_ = Stage::kHashMove;
+
+  MoveList captures_;
+  std::size_t current_capture_ = 0;
+
+  std::array<Move, kKillerCount> killer_moves_;
+  std::size_t killer_count_ = 0;
+  std::size_t current_killer_ = 0;
+
+  MoveList quiets_;
+  std::size_t current_quiet_ = 0;
+};
+
+inline std::optional<Move> MovePicker::SelectNextMove() {
+  switch (stage_) {
+    case Stage::kHashMove:
+      stage_ = Stage::kGenerateCaptures;
+      // a move of another position with the same key is dropped
+      if (hash_move_ && IsPlayable(*hash_move_)) {
+        return hash_move_;
+      }
+      hash_move_.reset();
+      [[fallthrough]];
+
+    case Stage::kGenerateCaptures:
+      if (position_.IsUnderCheck()) {
+        GenerateEvasions();
+      } else {
+        MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kQuiescence>(
+            position_, captures_);
+      }
+      for (std::size_t i = 0; i < captures_.size(); ++i) {
+        captures_.GetScore(i) = ScoreCapture(captures_[i]);
+      }
+      stage_ = Stage::kGoodCaptures;
+      [[fallthrough]];
+
+    case Stage::kGoodCaptures:
+      while (current_capture_ < captures_.size()) {
+        const auto move =
+            PickBest(captures_, current_capture_, captures_.size());
+        // only losing captures have negative scores
+        if (captures_.GetScore(current_capture_) < 0) {
+          break;
+        }
+        ++current_capture_;
+        if (move != hash_move_) {
+          return move;
+        }
+      }
+      stage_ = Stage::kSelectKillers;
+      [[fallthrough]];
+
+    case Stage::kSelectKillers:
+      for (std::size_t i = 0; i < killers_.AvailableKillerCount(ply_); ++i) {
+        const auto killer = killers_.Get(ply_, i);
+        // captures and promotions were given by the previous stages
+        if (killer != hash_move_ && killer.GetType() != MoveType::kPromotion &&
+            position_.IsQuiet(killer) && IsPlayable(killer)) {
+          killer_moves_[killer_count_++] = killer;
+        }
+      }
+      // the killer with the better history goes first
+      if (killer_count_ == kKillerCount &&
+          ScoreQuiet(killer_moves_[1]) > ScoreQuiet(killer_moves_[0])) {
+        std::swap(killer_moves_[0], killer_moves_[1]);
+      }
+      stage_ = Stage::kKillers;
+      [[fallthrough]];
+
+    case Stage::kKillers:
+      if (current_killer_ < killer_count_) {
+        return killer_moves_[current_killer_++];
+      }
+      stage_ = Stage::kGenerateQuiets;
+      [[fallthrough]];
+
+    case Stage::kGenerateQuiets:
+      // quiet evasions are already generated with the captures
+      if (!position_.IsUnderCheck()) {
+        MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kQuiet>(position_,
+                                                                   quiets_);
+      }
+      for (std::size_t i = 0; i < quiets_.size(); ++i) {
+        quiets_.GetScore(i) = ScoreQuiet(quiets_[i]);
+      }
+      stage_ = Stage::kQuiets;
+      [[fallthrough]];
+
+    case Stage::kQuiets:
+      while (current_quiet_ < quiets_.size()) {
+        const auto move = PickBest(quiets_, current_quiet_++, quiets_.size());
+        if (move != hash_move_ && !IsKiller(move)) {
+          return move;
+        }
+      }
+      stage_ = Stage::kBadCaptures;
+      [[fallthrough]];
+
+    case Stage::kBadCaptures:
+      while (current_capture_ < captures_.size()) {
+        const auto move =
+            PickBest(captures_, current_capture_++, captures_.size());
+        if (move != hash_move_) {
+          return move;
+        }
+      }
+      stage_ = Stage::kDone;
+      [[fallthrough]];
+
+    case Stage::kDone:
+      return std::nullopt;
+  }
+  return std::nullopt;
+}
+
+inline MoveScore MovePicker::ScoreCapture(const Move& move) const {
+  constexpr auto kPieceWeight = 8;
+
+  const auto captured =
+      static_cast<MoveScore>(position_.GetCapturedPiece(move));
+  const auto moving =
+      static_cast<MoveScore>(position_.GetPiece(move.GetFrom()));
+
+  auto score = kPieceWeight * captured - moving;
+
+  switch (move.GetType()) {
+    case MoveType::kPromotion:
+      return score +
+             kPieceWeight * static_cast<MoveScore>(move.GetPromotedTo());
+    case MoveType::kEnCroissant:
+      return score;
+    default:
+      // taking a cheaper piece may lose material, so it is tried last
+      return captured < moving ? score + kBadCaptureScore : score;
+  }
+}
+
+inline MoveScore MovePicker::ScoreQuiet(const Move& move) const {
+  return static_cast<MoveScore>(
+      std::min<uint64_t>(history_[move.GetFrom()][move.GetTo()],
+                         std::numeric_limits<MoveScore>::max()));
+}
+
+inline bool MovePicker::IsPlayable(const Move& move) const {
+  return position_.IsPseudoLegal(move) && position_.IsLegal(move);
+}
+
+inline void MovePicker::GenerateEvasions() {
+  const auto evasions =
+      MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kEvasions>(position_);
+  for (const auto& move : evasions) {
+    if (move.GetType() == MoveType::kPromotion || !position_.IsQuiet(move)) {
+      captures_.push_back(move);
+    } else {
+      quiets_.push_back(move);
+    }
+  }
+}
+
+inline bool MovePicker::IsKiller(const Move& move) const {
+  return std::find(killer_moves_.begin(),
+                   killer_moves_.begin() + killer_count_,
+                   move) != killer_moves_.begin() + killer_count_;
+}
+
+inline Move MovePicker::PickBest(MoveList& moves, const std::size_t index,
+                                 const std::size_t end) {
+  auto best = index;
+  for (auto i = index + 1; i < end; ++i) {
+    if (moves.GetScore(i) > moves.GetScore(best)) {
+      best = i;
+    }
+  }
+  moves.Swap(index, best);
+  return moves[index];
+}
+}  // namespace SimpleChessEngine
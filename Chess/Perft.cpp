@@ -17,25 +17,19 @@ size_t Perft(std::ostream& o_stream, Position& position, const Depth depth) {
 
   for (const auto& move : moves) {
     if constexpr (print) {
-      std::visit(
-          [&o_stream](const auto& unwrapped_move) {
-            o_stream << unwrapped_move;
-          },
-          move);
-      o_stream << ": ";
+      o_stream << move << ": ";
     }
 
     size_t cur_answer;
 
     if (depth > 1) {
-      const auto irreversible_data = position.GetIrreversibleData();
       position.DoMove(move);
 
       cur_answer = Perft<false>(o_stream, position, depth - 1);
       if constexpr (print) {
         o_stream << cur_answer << std::endl;
       }
-      position.UndoMove(move, irreversible_data);
+      position.UndoMove(move);
     } else {
       cur_answer = Perft<false>(o_stream, position, depth - 1);
       if constexpr (print) {
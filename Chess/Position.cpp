@@ -1,269 +1,528 @@
 #include "Position.h"
 
 #include <numeric>
-#include <variant>
 
 using namespace SimpleChessEngine;
 
-void Position::DoMove(const Move& move)
+namespace
 {
-  if (const auto& ep_square = irreversible_data_.en_croissant_square;
-      ep_square.has_value())
-  {
-    hash_ ^= hasher_.en_croissant_hash[GetCoordinates(ep_square.value()).first];
-    irreversible_data_.en_croissant_square.reset();
-  }
-  for (const auto color : {Player::kWhite, Player::kBlack})
-  {
-    hash_ ^= hasher_.cr_hash[static_cast<size_t>(
-        color)][irreversible_data_.castling_rights[static_cast<size_t>(color)]
-                    .to_ulong()];
-  }
-
-  std::visit([this](const auto& unwrapped_move) { DoMove(unwrapped_move); },
-             move);
-
-  for (const auto color : {Player::kWhite, Player::kBlack})
+[[nodiscard]] Bitboard GetPieceAttacks(const Piece piece, const BitIndex from,
+                                       const Bitboard occupancy)
+{
+  switch (piece)
   {
-    hash_ ^= hasher_.cr_hash[static_cast<size_t>(
-        color)][irreversible_data_.castling_rights[static_cast<size_t>(color)]
-                    .to_ulong()];
+    case Piece::kKnight:
+      return AttackTable<Piece::kKnight>::GetAttackMap(from, occupancy);
+    case Piece::kBishop:
+      return AttackTable<Piece::kBishop>::GetAttackMap(from, occupancy);
+    case Piece::kRook:
+      return AttackTable<Piece::kRook>::GetAttackMap(from, occupancy);
+    case Piece::kQueen:
+      return AttackTable<Piece::kQueen>::GetAttackMap(from, occupancy);
+    case Piece::kKing:
+      return AttackTable<Piece::kKing>::GetAttackMap(from, occupancy);
+    default:
+      return kEmptyBoard;
   }
-  side_to_move_ = Flip(side_to_move_);
-  hash_ ^= hasher_.stm_hash;
+}
 
-  history_stack_.Push(hash_, DoesReset(move));
+[[nodiscard]] bool IsSliderCheck(const BitIndex king_square,
+                                 const Bitboard occupancy,
+                                 const Bitboard bishops, const Bitboard rooks,
+                                 const Bitboard queens)
+{
+  return ((AttackTable<Piece::kBishop>::GetAttackMap(king_square, occupancy) &
+           (bishops | queens)) |
+          (AttackTable<Piece::kRook>::GetAttackMap(king_square, occupancy) &
+           (rooks | queens)))
+      .Any();
 }
+}  // namespace
 
-void Position::DoMove(const DefaultMove& move)
+void Position::DoMove(const Move move)
 {
-  const auto [from, to, captured_piece] = move;
+  const auto from = move.GetFrom();
+  const auto to = move.GetTo();
 
   const auto us = side_to_move_;
   const auto them = Flip(us);
+  const auto us_idx = static_cast<size_t>(us);
+  const auto them_idx = static_cast<size_t>(them);
 
   const auto piece_to_move = board_[from];
   assert(!!piece_to_move);
+  const auto captured_piece = GetCapturedPiece(move);
 
-  if (!!captured_piece) RemovePiece(to, them);
-  MovePiece(from, to, us);
+  states_.Push();
+  auto& state = GetState();
+  ++state.plies_from_null;
 
-  if (piece_to_move == Piece::kKing)
+  if (piece_to_move == Piece::kPawn || !!captured_piece)
+  {
+    state.rule50 = 0;
+  }
+  else
   {
-    king_position_[static_cast<size_t>(us)] = to;
-    irreversible_data_.castling_rights[static_cast<size_t>(us)] = 0;
+    ++state.rule50;
   }
 
-  for (auto castling_side :
-       {Castling::CastlingSide::k00, Castling::CastlingSide::k000})
+  if (const auto& ep_square = state.en_croissant_square;
+      ep_square.has_value())
+  {
+    state.hash ^=
+        kHasher.en_croissant_hash[GetCoordinates(ep_square.value()).first];
+    state.en_croissant_square.reset();
+  }
+  for (const auto color : {Player::kWhite, Player::kBlack})
+  {
+    state.hash ^= kHasher.cr_hash[static_cast<size_t>(
+        color)][state.castling_rights[static_cast<size_t>(color)]
+                    .to_ulong()];
+  }
+
+  state.captured_piece = captured_piece;
+
+  switch (move.GetType())
+  {
+    case MoveType::kDefault:
+      if (!!captured_piece) RemovePiece(to, them);
+      MovePiece(from, to, us);
+      if (piece_to_move == Piece::kKing)
+      {
+        king_position_[us_idx] = to;
+        state.castling_rights[us_idx] = 0;
+      }
+      break;
+    case MoveType::kDoublePush:
+      state.hash ^= kHasher.en_croissant_hash[GetCoordinates(from).first];
+      state.en_croissant_square = std::midpoint(from, to);
+      MovePiece(from, to, us);
+      break;
+    case MoveType::kEnCroissant:
+      RemovePiece(Shift(to, kPawnMoveDirection[them_idx]), them);
+      MovePiece(from, to, us);
+      break;
+    case MoveType::kPromotion:
+      RemovePiece(from, us);
+      if (!!captured_piece) RemovePiece(to, them);
+      PlacePiece(to, move.GetPromotedTo(), us);
+      break;
+    case MoveType::kCastling:
+    {
+      const auto side_idx = static_cast<size_t>(move.GetCastlingSide());
+      RemovePiece(from, us);
+      RemovePiece(to, us);
+      PlacePiece(kKingCastlingDestination[us_idx][side_idx], Piece::kKing, us);
+      PlacePiece(kRookCastlingDestination[us_idx][side_idx], Piece::kRook, us);
+      king_position_[us_idx] = kKingCastlingDestination[us_idx][side_idx];
+      state.castling_rights[us_idx] = 0;
+      break;
+    }
+  }
+
+  // a rook that leaves or is captured on its square loses its castling
+  for (const auto castling_side : {CastlingSide::k00, CastlingSide::k000})
   {
-    const auto our_rook = rook_positions_[static_cast<size_t>(us)]
-                                         [static_cast<size_t>(castling_side)];
-    const auto their_rook = rook_positions_[static_cast<size_t>(them)]
-                                           [static_cast<size_t>(castling_side)];
-    if (from == our_rook)
+    const auto side_idx = static_cast<size_t>(castling_side);
+    const auto rights = ~static_cast<int8_t>(kCastlingRightsForSide[side_idx]);
+    if (from == rook_positions_[us_idx][side_idx])
     {
-      irreversible_data_.castling_rights[static_cast<size_t>(us)] &=
-          ~static_cast<int8_t>(
-              kCastlingRightsForSide[static_cast<size_t>(castling_side)]);
+      state.castling_rights[us_idx] &= rights;
     }
-    if (to == their_rook)
+    if (to == rook_positions_[them_idx][side_idx])
     {
-      irreversible_data_.castling_rights[static_cast<size_t>(them)] &=
-          ~static_cast<int8_t>(
-              kCastlingRightsForSide[static_cast<size_t>(castling_side)]);
+      state.castling_rights[them_idx] &= rights;
     }
   }
-}
 
-void Position::DoMove(const PawnPush& move)
-{
-  const auto [from, to] = move;
-
-  const auto us = side_to_move_;
+  for (const auto color : {Player::kWhite, Player::kBlack})
+  {
+    state.hash ^= kHasher.cr_hash[static_cast<size_t>(
+        color)][state.castling_rights[static_cast<size_t>(color)]
+                    .to_ulong()];
+  }
+  side_to_move_ = them;
+  state.hash ^= kHasher.stm_hash;
 
-  MovePiece(from, to, us);
+  ComputeCheckInfo();
 }
 
-void Position::DoMove(const DoublePush& move)
+void Position::DoNullMove()
 {
-  const auto [from, to] = move;
-  const auto file = GetCoordinates(from).first;
+  assert(!IsUnderCheck());
 
-  const auto us = side_to_move_;
+  states_.Push();
+  auto& state = GetState();
+  ++state.rule50;
+  state.plies_from_null = 0;
+  state.captured_piece = Piece::kNone;
+
+  if (const auto& ep_square = state.en_croissant_square;
+      ep_square.has_value())
+  {
+    state.hash ^=
+        kHasher.en_croissant_hash[GetCoordinates(ep_square.value()).first];
+    state.en_croissant_square.reset();
+  }
+
+  side_to_move_ = Flip(side_to_move_);
+  state.hash ^= kHasher.stm_hash;
 
-  hash_ ^= hasher_.en_croissant_hash[file];
-  irreversible_data_.en_croissant_square = std::midpoint(from, to);
+  ComputeCheckInfo();
+}
 
-  MovePiece(from, to, us);
+void Position::UndoNullMove()
+{
+  side_to_move_ = Flip(side_to_move_);
+  states_.Pop();
 }
 
-void Position::DoMove(const EnCroissant& move)
+Hash Position::GetHashAfter(const Move move) const
 {
-  const auto [from, to] = move;
+  const auto from = move.GetFrom();
+  const auto to = move.GetTo();
 
   const auto us = side_to_move_;
   const auto them = Flip(us);
+  const auto us_idx = static_cast<size_t>(us);
+  const auto them_idx = static_cast<size_t>(them);
 
-  const auto capture_square =
-      Shift(to, kPawnMoveDirection[static_cast<size_t>(them)]);
+  const auto piece_hash = [this](const Piece piece, const size_t color_idx,
+                                 const BitIndex square)
+  { return kHasher.psqt_hash[static_cast<size_t>(piece)][color_idx][square]; };
 
-  RemovePiece(capture_square, them);
-  MovePiece(from, to, us);
-}
+  auto hash = GetHash() ^ kHasher.stm_hash;
+  if (const auto& ep_square = GetState().en_croissant_square;
+      ep_square.has_value())
+  {
+    hash ^= kHasher.en_croissant_hash[GetCoordinates(ep_square.value()).first];
+  }
 
-void Position::DoMove(const Promotion& move)
-{
-  const auto [from, to, captured_piece] = static_cast<DefaultMove>(move);
-  const auto promoted_to = move.promoted_to;
+  auto castling_rights = GetState().castling_rights;
 
-  const auto us = side_to_move_;
-  const auto them = Flip(us);
+  const auto piece = board_[from];
+  const auto captured_piece = GetCapturedPiece(move);
 
-  RemovePiece(from, us);
-  if (!!captured_piece) RemovePiece(to, them);
-  PlacePiece(to, promoted_to, us);
+  switch (move.GetType())
+  {
+    case MoveType::kDefault:
+      if (!!captured_piece) hash ^= piece_hash(captured_piece, them_idx, to);
+      hash ^= piece_hash(piece, us_idx, from) ^ piece_hash(piece, us_idx, to);
+      if (piece == Piece::kKing) castling_rights[us_idx] = 0;
+      break;
+    case MoveType::kDoublePush:
+      hash ^= kHasher.en_croissant_hash[GetCoordinates(from).first];
+      hash ^= piece_hash(piece, us_idx, from) ^ piece_hash(piece, us_idx, to);
+      break;
+    case MoveType::kEnCroissant:
+      hash ^= piece_hash(Piece::kPawn, them_idx,
+                         Shift(to, kPawnMoveDirection[them_idx]));
+      hash ^= piece_hash(piece, us_idx, from) ^ piece_hash(piece, us_idx, to);
+      break;
+    case MoveType::kPromotion:
+      if (!!captured_piece) hash ^= piece_hash(captured_piece, them_idx, to);
+      hash ^= piece_hash(piece, us_idx, from) ^
+              piece_hash(move.GetPromotedTo(), us_idx, to);
+      break;
+    case MoveType::kCastling:
+    {
+      const auto side_idx = static_cast<size_t>(move.GetCastlingSide());
+      hash ^= piece_hash(Piece::kKing, us_idx, from) ^
+              piece_hash(Piece::kRook, us_idx, to) ^
+              piece_hash(Piece::kKing, us_idx,
+                         kKingCastlingDestination[us_idx][side_idx]) ^
+              piece_hash(Piece::kRook, us_idx,
+                         kRookCastlingDestination[us_idx][side_idx]);
+      castling_rights[us_idx] = 0;
+      break;
+    }
+  }
 
-  for (const auto castling_side :
-       {Castling::CastlingSide::k00, Castling::CastlingSide::k000})
+  for (const auto castling_side : {CastlingSide::k00, CastlingSide::k000})
   {
-    const auto their_rook = rook_positions_[static_cast<size_t>(them)]
-                                           [static_cast<size_t>(castling_side)];
-    if (to == their_rook)
+    const auto side_idx = static_cast<size_t>(castling_side);
+    const auto rights = ~static_cast<int8_t>(kCastlingRightsForSide[side_idx]);
+    if (from == rook_positions_[us_idx][side_idx])
+    {
+      castling_rights[us_idx] &= rights;
+    }
+    if (to == rook_positions_[them_idx][side_idx])
     {
-      irreversible_data_.castling_rights[static_cast<size_t>(them)] &=
-          ~static_cast<char>(
-              kCastlingRightsForSide[static_cast<size_t>(castling_side)]);
+      castling_rights[them_idx] &= rights;
     }
   }
+
+  for (const auto color_idx : {us_idx, them_idx})
+  {
+    const auto old_rights = GetState().castling_rights[color_idx];
+    hash ^= kHasher.cr_hash[color_idx][old_rights.to_ulong()] ^
+            kHasher.cr_hash[color_idx][castling_rights[color_idx].to_ulong()];
+  }
+
+  return hash;
 }
 
-void Position::DoMove(const Castling& move)
+bool Position::IsPseudoLegal(const Move move) const
 {
-  const auto [side, king_from, rook_from] = move;
+  const auto from = move.GetFrom();
+  const auto to = move.GetTo();
+  const auto type = move.GetType();
 
   const auto us = side_to_move_;
+  const auto us_idx = static_cast<size_t>(us);
+  const auto piece = board_[from];
+  const auto captured_piece = board_[to];
 
-  const auto color_idx = static_cast<size_t>(us);
-  const auto side_idx = static_cast<size_t>(side);
-
-  RemovePiece(king_from, us);
-  RemovePiece(rook_from, us);
-  PlacePiece(kKingCastlingDestination[color_idx][side_idx], Piece::kKing, us);
-  PlacePiece(kRookCastlingDestination[color_idx][side_idx], Piece::kRook, us);
-
-  king_position_[static_cast<size_t>(us)] =
-      kKingCastlingDestination[color_idx][side_idx];
-  irreversible_data_.castling_rights[static_cast<size_t>(us)] = 0;
-}
-
-void Position::UndoMove(const Move& move, const IrreversibleData& data)
-{
-  const auto& ep_square = irreversible_data_.en_croissant_square;
-  for (const auto color : {Player::kWhite, Player::kBlack})
+  if (!GetPieces(us).Test(from))
   {
-    hash_ ^= hasher_.cr_hash[static_cast<size_t>(
-        color)][irreversible_data_.castling_rights[static_cast<size_t>(color)]
-                    .to_ulong()];
+    return false;
   }
-  if (ep_square.has_value())
+
+  if (type == MoveType::kCastling)
   {
-    hash_ ^= hasher_.en_croissant_hash[GetCoordinates(ep_square.value()).first];
+    const auto side = move.GetCastlingSide();
+    return piece == Piece::kKing && !IsUnderCheck() &&
+           GetCastlingRookSquare(us, side) == to && CanCastle(side);
   }
-  irreversible_data_ = data;
-  for (const auto color : {Player::kWhite, Player::kBlack})
+
+  if (GetPieces(us).Test(to) || captured_piece == Piece::kKing)
   {
-    hash_ ^= hasher_.cr_hash[static_cast<size_t>(
-        color)][irreversible_data_.castling_rights[static_cast<size_t>(color)]
-                    .to_ulong()];
+    return false;
   }
-  if (ep_square.has_value())
+
+  if (piece != Piece::kPawn)
   {
-    hash_ ^= hasher_.en_croissant_hash[GetCoordinates(ep_square.value()).first];
+    return type == MoveType::kDefault &&
+           GetPieceAttacks(piece, from, GetAllPieces()).Test(to);
   }
-  hash_ ^= hasher_.stm_hash;
-  side_to_move_ = Flip(side_to_move_);
-  std::visit([this](const auto& unwrapped_move) { UndoMove(unwrapped_move); },
-             move);
 
-  history_stack_.Pop();
+  const auto direction = kPawnMoveDirection[us_idx];
+  const auto is_push = to == Shift(from, direction) && !captured_piece;
+  const auto is_capture = GetPawnAttacks(from, us).Test(to) && !!captured_piece;
+  const auto is_last_rank = (kRankBB[0] | kRankBB[kLineSize - 1]).Test(to);
+
+  switch (type)
+  {
+    case MoveType::kDefault:
+      return !is_last_rank && (is_push || is_capture);
+    case MoveType::kDoublePush:
+      return to == Shift(Shift(from, direction), direction) &&
+             !captured_piece && !board_[Shift(from, direction)] &&
+             kDoubleMoveSpan[us_idx][GetCoordinates(from).first].Test(to);
+    case MoveType::kEnCroissant:
+      return GetPawnAttacks(from, us).Test(to) &&
+             GetState().en_croissant_square == to;
+    default:
+      return is_last_rank && (is_push || is_capture) &&
+             move.GetPromotedTo() <= Piece::kQueen;
+  }
 }
 
-void Position::UndoMove(const DefaultMove& move)
+bool Position::IsLegal(const Move move) const
 {
-  const auto [from, to, captured_piece] = move;
+  assert(IsPseudoLegal(move));
+
+  // castling is checked completely by CanCastle
+  if (move.GetType() == MoveType::kCastling)
+  {
+    return true;
+  }
 
-  const Player us = side_to_move_;
-  const Player them = Flip(us);
+  const auto from = move.GetFrom();
+  const auto to = move.GetTo();
 
-  const auto piece_to_move = board_[to];
+  const auto us = side_to_move_;
+  const auto them = Flip(us);
 
-  MovePiece(to, from, us);
-  if (!!captured_piece) PlacePiece(to, captured_piece, them);
+  // squares of pieces that are gone after the move
+  auto removed = GetBitboardOfSquare(from) | GetBitboardOfSquare(to);
+  if (move.GetType() == MoveType::kEnCroissant)
+  {
+    removed |= GetBitboardOfSquare(
+        Shift(to, kPawnMoveDirection[static_cast<size_t>(them)]));
+  }
 
-  if (piece_to_move == Piece::kKing)
-    king_position_[static_cast<size_t>(us)] = from;
+  const auto occupancy = (GetAllPieces() & ~removed) | GetBitboardOfSquare(to);
+  const auto king_square =
+      board_[from] == Piece::kKing ? to : GetKingSquare(us);
+  const auto enemies = GetPieces(them) & ~removed;
+
+  const auto diagonal_attackers =
+      pieces_by_type_[static_cast<size_t>(Piece::kBishop)] |
+      pieces_by_type_[static_cast<size_t>(Piece::kQueen)];
+  const auto straight_attackers =
+      pieces_by_type_[static_cast<size_t>(Piece::kRook)] |
+      pieces_by_type_[static_cast<size_t>(Piece::kQueen)];
+
+  const auto attackers =
+      (GetPawnAttacks(king_square, us) &
+       pieces_by_type_[static_cast<size_t>(Piece::kPawn)]) |
+      (AttackTable<Piece::kKnight>::GetAttackMap(king_square, occupancy) &
+       pieces_by_type_[static_cast<size_t>(Piece::kKnight)]) |
+      (AttackTable<Piece::kKing>::GetAttackMap(king_square, occupancy) &
+       pieces_by_type_[static_cast<size_t>(Piece::kKing)]) |
+      (AttackTable<Piece::kBishop>::GetAttackMap(king_square, occupancy) &
+       diagonal_attackers) |
+      (AttackTable<Piece::kRook>::GetAttackMap(king_square, occupancy) &
+       straight_attackers);
+
+  return (attackers & enemies).None();
 }
 
-void Position::UndoMove(const PawnPush& move)
+bool Position::GivesCheck(const Move move) const
 {
-  const auto [from, to] = move;
+  const auto from = move.GetFrom();
+  const auto to = move.GetTo();
 
   const auto us = side_to_move_;
+  const auto them = Flip(us);
+  const auto king_square = GetKingSquare(them);
+  const auto piece = board_[from];
 
-  MovePiece(to, from, us);
-}
-
-void Position::UndoMove(const DoublePush& move)
-{
-  const auto from = move.from;
+  // direct check, the piece on its new square attacks the king
+  if (move.GetType() != MoveType::kPromotion &&
+      move.GetType() != MoveType::kCastling &&
+      GetCheckSquares(piece).Test(to))
+  {
+    return true;
+  }
 
-  const auto us = side_to_move_;
+  // discovered check, the piece leaves the line between a slider and the king
+  if (GetBlockers(them).Test(from) && !Ray(king_square, from).Test(to) &&
+      move.GetType() != MoveType::kCastling)
+  {
+    return true;
+  }
 
-  const auto to = move.to;
+  const auto occupancy = GetAllPieces() ^ GetBitboardOfSquare(from);
 
-  MovePiece(to, from, us);
+  switch (move.GetType())
+  {
+    case MoveType::kPromotion:
+      return GetPieceAttacks(move.GetPromotedTo(), to, occupancy)
+          .Test(king_square);
+    case MoveType::kEnCroissant:
+    {
+      // the captured pawn may also uncover a line to the king
+      const auto captured_square =
+          Shift(to, kPawnMoveDirection[static_cast<size_t>(them)]);
+      const auto after = (occupancy ^ GetBitboardOfSquare(captured_square)) |
+                         GetBitboardOfSquare(to);
+      return IsSliderCheck(king_square, after,
+                           GetPiecesByType<Piece::kBishop>(us),
+                           GetPiecesByType<Piece::kRook>(us),
+                           GetPiecesByType<Piece::kQueen>(us));
+    }
+    case MoveType::kCastling:
+    {
+      // both the king and the rook leave their squares
+      const auto side_idx = static_cast<size_t>(move.GetCastlingSide());
+      const auto us_idx = static_cast<size_t>(us);
+      const auto rook_square = kRookCastlingDestination[us_idx][side_idx];
+      const auto after =
+          (occupancy ^ GetBitboardOfSquare(to)) |
+          GetBitboardOfSquare(kKingCastlingDestination[us_idx][side_idx]) |
+          GetBitboardOfSquare(rook_square);
+      return IsSliderCheck(king_square, after,
+                           GetPiecesByType<Piece::kBishop>(us),
+                           (GetPiecesByType<Piece::kRook>(us) ^
+                            GetBitboardOfSquare(to)) |
+                               GetBitboardOfSquare(rook_square),
+                           GetPiecesByType<Piece::kQueen>(us));
+    }
+    default:
+      return false;
+  }
 }
 
-void Position::UndoMove(const EnCroissant& move)
+bool Position::HasUpcomingRepetition(const size_t ply) const
 {
-  const auto [from, to] = move;
+  const auto depth =
+      std::min(GetState().rule50, GetState().plies_from_null);
+  if (depth < 3)
+  {
+    return false;
+  }
 
-  const auto us = side_to_move_;
-  const auto them = Flip(us);
+  const auto hash = GetHash();
+  // difference of the positions made by the moves of the opponent only
+  auto other = hash ^ states_.Back(1).hash ^ kHasher.stm_hash;
+  for (size_t plies = 3; plies <= depth; plies += 2)
+  {
+    other ^= states_.Back(plies - 1).hash ^ states_.Back(plies).hash ^
+             kHasher.stm_hash;
+    if (other != 0)
+    {
+      continue;
+    }
 
-  const auto capture_square =
-      Shift(to, kPawnMoveDirection[static_cast<size_t>(them)]);
+    const auto move_key = hash ^ states_.Back(plies).hash;
+    auto index = CuckooFirstIndex(move_key);
+    if (cuckoo_keys[index] != move_key)
+    {
+      index = CuckooSecondIndex(move_key);
+      if (cuckoo_keys[index] != move_key)
+      {
+        continue;
+      }
+    }
 
-  MovePiece(to, from, us);
-  PlacePiece(capture_square, Piece::kPawn, them);
+    const auto move = cuckoo_moves[index];
+    const auto path = Between(move.GetFrom(), move.GetTo()) &
+                      ~GetBitboardOfSquare(move.GetTo());
+    if ((path & GetAllPieces()).None() && ply > plies)
+    {
+      return true;
+    }
+  }
+  return false;
 }
 
-void Position::UndoMove(const Promotion& move)
+void Position::UndoMove(const Move move)
 {
-  const auto [from, to, captured_piece] = static_cast<DefaultMove>(move);
-
-  const auto us = side_to_move_;
-  const auto them = Flip(us);
+  const auto captured_piece = GetState().captured_piece;
 
-  RemovePiece(to, us);
-  if (!!captured_piece) PlacePiece(to, captured_piece, them);
-  PlacePiece(from, Piece::kPawn, us);
-}
+  side_to_move_ = Flip(side_to_move_);
 
-void Position::UndoMove(const Castling& move)
-{
-  const auto [side, king_from, rook_from] = move;
+  const auto from = move.GetFrom();
+  const auto to = move.GetTo();
 
   const auto us = side_to_move_;
+  const auto them = Flip(us);
+  const auto us_idx = static_cast<size_t>(us);
 
-  const auto color_idx = static_cast<size_t>(us);
-  const auto side_idx = static_cast<size_t>(side);
-
-  PlacePiece(king_from, Piece::kKing, us);
-  PlacePiece(rook_from, Piece::kRook, us);
-  RemovePiece(kKingCastlingDestination[color_idx][side_idx], us);
-  RemovePiece(kRookCastlingDestination[color_idx][side_idx], us);
+  switch (move.GetType())
+  {
+    case MoveType::kDefault:
+      MovePiece(to, from, us);
+      if (!!captured_piece) PlacePiece(to, captured_piece, them);
+      if (board_[from] == Piece::kKing) king_position_[us_idx] = from;
+      break;
+    case MoveType::kDoublePush:
+      MovePiece(to, from, us);
+      break;
+    case MoveType::kEnCroissant:
+      MovePiece(to, from, us);
+      PlacePiece(Shift(to, kPawnMoveDirection[static_cast<size_t>(them)]),
+                 Piece::kPawn, them);
+      break;
+    case MoveType::kPromotion:
+      RemovePiece(to, us);
+      if (!!captured_piece) PlacePiece(to, captured_piece, them);
+      PlacePiece(from, Piece::kPawn, us);
+      break;
+    case MoveType::kCastling:
+    {
+      const auto side_idx = static_cast<size_t>(move.GetCastlingSide());
+      RemovePiece(kKingCastlingDestination[us_idx][side_idx], us);
+      RemovePiece(kRookCastlingDestination[us_idx][side_idx], us);
+      PlacePiece(from, Piece::kKing, us);
+      PlacePiece(to, Piece::kRook, us);
+      king_position_[us_idx] = from;
+      break;
+    }
+  }
 
-  king_position_[static_cast<size_t>(us)] = king_from;
-}
\ No newline at end of file
+  // the previous state keeps the hash, so the one changed above is dropped
+  states_.Pop();
+}
@@ -1,17 +1,23 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <bitset>
 #include <cassert>
-#include <random>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
 
 #include "Attacks.h"
 #include "Bitboard.h"
+#include "Cuckoo.h"
 #include "Evaluation.h"
 #include "Hasher.h"
 #include "Move.h"
 #include "PSQT.h"
 #include "Piece.h"
 #include "Player.h"
+#include "SetwiseAttacks.h"
 #include "Utility.h"
 
 namespace SimpleChessEngine {
@@ -26,60 +32,139 @@ class Position {
   struct EvaluationData {
     bool operator==(const EvaluationData&) const = default;
 
-    Eval non_pawn_material{};
+    std::array<Eval, kColors> non_pawn_material{};
     std::array<TaperedEval, kColors> material{};
     std::array<TaperedEval, kColors> psqt{};
   };
 
   [[nodiscard]] Eval Evaluate() const;
 
-  struct IrreversibleData {
+  /**
+   * \brief Data of a position that can not be restored by undoing a move.
+   */
+  struct StateInfo {
+    Hash hash{};  //!< Hash of the position.
+
     std::optional<BitIndex> en_croissant_square{};
 
     std::array<std::bitset<2>, kColors> castling_rights{};
 
+    //! Plies since the last capture or pawn move.
+    uint16_t rule50{};
+
+    //! Plies since the last null move or the first state.
+    uint16_t plies_from_null{};
+
     std::array<Bitboard, kColors> pinners{};
     std::array<Bitboard, kColors> blockers{};
 
-    bool operator==(const IrreversibleData& other) const {
+    Bitboard checkers{};  //!< Pieces that give check to the side to move.
+
+    //! Squares where a piece of the side to move would give check.
+    std::array<Bitboard, kPieceTypes> check_squares{};
+
+    //! Squares attacked by the opponent, computed on the first request.
+    mutable std::optional<Bitboard> enemy_attacks{};
+
+    Piece captured_piece{};  //!< Piece captured by the last move.
+
+    bool operator==(const StateInfo& other) const {
       return std::tie(en_croissant_square, castling_rights) ==
              std::tie(other.en_croissant_square, other.castling_rights);
     }
   };
 
-  struct GameHistory {
-    static constexpr size_t kHistorySize = 1024;
-    std::vector<Hash> history{};
-    std::vector<size_t> last_reset{};
+  /**
+   * \brief Stack of states of the game, one for each ply.
+   *
+   * \details States live in a fixed array, so doing a move just takes the
+   * next slot and undoing it steps back, nothing is ever allocated. The array
+   * holds the search plies and the rule-50 window behind them, older states
+   * can not be repeated and are dropped. Slots are left uninitialized until
+   * used, so a copy writes only the states in use.
+   */
+  class StateStack {
+   public:
+    //! Plies after which the game is drawn by the fifty-move rule.
+    static constexpr size_t kRule50Plies = 100;
+    static constexpr size_t kCapacity = kMaxSearchPly + kRule50Plies + 1;
 
-    GameHistory() {
-      history.reserve(kHistorySize);
-      last_reset.reserve(kHistorySize + 1);
-      last_reset.push_back(0);
+    StateStack() { std::construct_at(&slots_[0].state); }
+
+    StateStack(const StateStack& other) : top_(other.top_) {
+      std::copy_n(other.slots_.begin(), top_ + 1, slots_.begin());
     }
 
-    size_t Count(const Hash hash) const {
-      size_t result = 0;
-      size_t parity_shift =
-          (history.size() ^ last_reset[history.size()] ^ 1) % 2;
-      for (size_t i = last_reset[history.size()] + parity_shift;
-           i < history.size(); i += 2) {
-        if (history[i] == hash) {
-          ++result;
-        }
-      }
-      return result;
+    StateStack& operator=(const StateStack& other) {
+      top_ = other.top_;
+      std::copy_n(other.slots_.begin(), top_ + 1, slots_.begin());
+      return *this;
     }
 
-    void Push(const Hash hash, const bool reset) {
-      last_reset.push_back(reset ? history.size() : last_reset.back());
-      history.push_back(hash);
+    [[nodiscard]] StateInfo& Top() { return slots_[top_].state; }
+    [[nodiscard]] const StateInfo& Top() const { return slots_[top_].state; }
+
+    /**
+     * \brief Gets the state of the position some plies ago.
+     */
+    [[nodiscard]] const StateInfo& Back(const size_t plies) const {
+      assert(plies <= top_);
+      return slots_[top_ - plies].state;
+    }
+
+    /**
+     * \brief Starts the state of the next ply with the data that carries
+     * over, the move fills in the rest.
+     */
+    void Push() {
+      if (top_ + 1 == kCapacity) {
+        DropOldest();
+      }
+      const auto& current = Top();
+      std::construct_at(&slots_[++top_].state,
+                        StateInfo{.hash = current.hash,
+                                  .en_croissant_square =
+                                      current.en_croissant_square,
+                                  .castling_rights = current.castling_rights,
+                                  .rule50 = current.rule50,
+                                  .plies_from_null = current.plies_from_null});
     }
 
     void Pop() {
-      history.pop_back();
-      last_reset.pop_back();
+      assert(top_ > 0);
+      --top_;
     }
+
+   private:
+    /**
+     * \brief Slot of a state that is constructed only when it is pushed.
+     */
+    union Slot {
+      Slot() {}
+
+      StateInfo state;
+    };
+
+    static_assert(std::is_trivially_copyable_v<StateInfo>);
+
+    /**
+     * \brief Moves the current state and the rule-50 window behind it to the
+     * bottom.
+     */
+    void DropOldest() {
+      constexpr size_t kKept = kRule50Plies + 1;
+      std::copy(slots_.end() - kKept, slots_.end(), slots_.begin());
+      top_ = kKept - 1;
+      // the first kept state has nothing before it
+      for (size_t i = 0; i < kKept; ++i) {
+        auto& plies_from_null = slots_[i].state.plies_from_null;
+        plies_from_null =
+            static_cast<uint16_t>(std::min<size_t>(plies_from_null, i));
+      }
+    }
+
+    std::array<Slot, kCapacity> slots_;
+    size_t top_ = 0;
   };
 
   /**
@@ -103,8 +188,9 @@ class Position {
     evaluation_data_.material[color_idx] += kPieceValues[piece_idx];
     evaluation_data_.psqt[color_idx] += kPSQT[color_idx][piece_idx][square];
     if (piece != Piece::kPawn)
-      evaluation_data_.non_pawn_material += kPieceValues[piece_idx].eval[0];
-    hash_ ^= hasher_.psqt_hash[piece_idx][color_idx][square];
+      evaluation_data_.non_pawn_material[color_idx] +=
+          kPieceValues[piece_idx].eval[0];
+    GetState().hash ^= kHasher.psqt_hash[piece_idx][color_idx][square];
   }
 
   /**
@@ -126,8 +212,9 @@ class Position {
     evaluation_data_.material[color_idx] -= kPieceValues[piece_idx];
     evaluation_data_.psqt[color_idx] -= kPSQT[color_idx][piece_idx][square];
     if (piece != Piece::kPawn)
-      evaluation_data_.non_pawn_material -= kPieceValues[piece_idx].eval[0];
-    hash_ ^= hasher_.psqt_hash[piece_idx][color_idx][square];
+      evaluation_data_.non_pawn_material[color_idx] -=
+          kPieceValues[piece_idx].eval[0];
+    GetState().hash ^= kHasher.psqt_hash[piece_idx][color_idx][square];
   }
 
   void MovePiece(const BitIndex from, const BitIndex to, const Player color) {
@@ -146,8 +233,8 @@ class Position {
     board_[to] = piece;
     evaluation_data_.psqt[color_idx] -= kPSQT[color_idx][piece_idx][from];
     evaluation_data_.psqt[color_idx] += kPSQT[color_idx][piece_idx][to];
-    hash_ ^= hasher_.psqt_hash[piece_idx][color_idx][from];
-    hash_ ^= hasher_.psqt_hash[piece_idx][color_idx][to];
+    GetState().hash ^= kHasher.psqt_hash[piece_idx][color_idx][from];
+    GetState().hash ^= kHasher.psqt_hash[piece_idx][color_idx][to];
   }
 
   /**
@@ -155,87 +242,104 @@ class Position {
    *
    * \param move Move to do.
    */
-  void DoMove(const Move& move);
+  void DoMove(Move move);
 
   /**
-   * \brief Does given move.
+   * \brief Undoes given move.
    *
-   * \param move Move to do.
+   * \param move Move to undo, it must be the last move done.
    */
-  void DoMove(const DefaultMove& move);
-
-  void DoMove(const PawnPush& move);
-
-  void DoMove(const DoublePush& move);
+  void UndoMove(Move move);
 
   /**
-   * \brief Does given move.
+   * \brief Passes the turn to the opponent.
    *
-   * \param move Move to do.
+   * \details The side to move must not be in check.
    */
-  void DoMove(const EnCroissant& move);
+  void DoNullMove();
 
   /**
-   * \brief Does given move.
-   *
-   * \param move Move to do.
+   * \brief Undoes the null move done last.
    */
-  void DoMove(const Promotion& move);
+  void UndoNullMove();
 
   /**
-   * \brief Does given move.
-   *
-   * \param move Move to do.
+   * \brief Gets the number of plies since the last null move.
    */
-
-  void DoMove(const Castling& move);
+  [[nodiscard]] size_t GetPliesFromNull() const {
+    return GetState().plies_from_null;
+  }
 
   /**
-   * \brief Undoes given move.
+   * \brief Gets the piece that the move captures.
+   *
+   * \param move Move to do.
    *
-   * \param move Move to undo.
+   * \return The captured piece or Piece::kNone if it is not a capture.
    */
-  void UndoMove(const Move& move, const IrreversibleData& data);
+  [[nodiscard]] Piece GetCapturedPiece(Move move) const;
 
   /**
-   * \brief Does given move.
+   * \brief Checks if the move does not capture anything.
    *
    * \param move Move to do.
+   *
+   * \return True if the move is not a capture, false otherwise.
    */
-  void UndoMove(const DefaultMove& move);
-
-  void UndoMove(const PawnPush& move);
-
-  void UndoMove(const DoublePush& move);
+  [[nodiscard]] bool IsQuiet(const Move move) const {
+    return !GetCapturedPiece(move);
+  }
 
   /**
-   * \brief Does given move.
+   * \brief Checks if the move can be played here, ignoring the own king.
    *
-   * \param move Move to do.
+   * \details Works for any 16-bit value, so a move from the transposition
+   * table or a killer of another position can be validated without
+   * generating moves. Castling is fully checked.
+   *
+   * \param move Move to check.
+   *
+   * \return True if the move is pseudo-legal, false otherwise.
    */
-  void UndoMove(const EnCroissant& move);
+  [[nodiscard]] bool IsPseudoLegal(Move move) const;
 
   /**
-   * \brief Does given move.
+   * \brief Checks if the pseudo-legal move does not leave the king in check.
    *
-   * \param move Move to do.
+   * \param move Pseudo-legal move to check.
+   *
+   * \return True if the move is legal, false otherwise.
    */
-  void UndoMove(const Promotion& move);
+  [[nodiscard]] bool IsLegal(Move move) const;
 
   /**
-   * \brief Does given move.
+   * \brief Checks if the move gives check, without doing it.
    *
-   * \param move Move to do.
+   * \param move Legal move to check.
+   *
+   * \return True if the opponent is in check after the move.
    */
-  void UndoMove(const Castling& move);
+  [[nodiscard]] bool GivesCheck(Move move) const;
+
+  [[nodiscard]] bool CanCastle(const CastlingSide castling_side) const {
+    return CanCastle(castling_side, GetEnemyAttacks());
+  }
 
-  [[nodiscard]] bool CanCastle(
-      const Castling::CastlingSide castling_side) const {
+  /**
+   * \brief Checks if the side to move can castle.
+   *
+   * \param castling_side Side of castling.
+   * \param attacked Squares attacked by the opponent, see GetEnemyAttacks.
+   *
+   * \return True if the castling is legal, false otherwise.
+   */
+  [[nodiscard]] bool CanCastle(const CastlingSide castling_side,
+                               const Bitboard attacked) const {
     const auto us = side_to_move_;
     const auto us_idx = static_cast<size_t>(us);
     const auto cs_idx = static_cast<size_t>(castling_side);
 
-    if (!irreversible_data_.castling_rights[us_idx].test(cs_idx)) return false;
+    if (!GetState().castling_rights[us_idx].test(cs_idx)) return false;
 
     const auto king_position = king_position_[us_idx];
     const auto rook_position = rook_positions_[us_idx][cs_idx];
@@ -244,23 +348,17 @@ class Position {
                            ~GetBitboardOfSquare(king_position) &
                            ~GetBitboardOfSquare(rook_position);
 
-    auto king_path = castling_squares_for_king_[us_idx][cs_idx];
+    const auto king_path = castling_squares_for_king_[us_idx][cs_idx];
 
     if (((king_path | castling_squares_for_rook_[us_idx][cs_idx]) & obstacles)
             .Any())
       return false;
 
-    while (king_path.Any()) {
-      if (const auto square = king_path.PopFirstBit();
-          IsUnderAttack(square, us))
-        return false;
-    }
-
-    return true;
+    return (king_path & attacked).None();
   }
 
   void SetCastlingRights(const std::array<std::bitset<2>, 2>& castling_rights) {
-    irreversible_data_.castling_rights = castling_rights;
+    GetState().castling_rights = castling_rights;
   }
 
   void SetKingPositions(const std::array<BitIndex, 2>& king_position) {
@@ -284,7 +382,16 @@ class Position {
    *
    * \return Hash of the position.
    */
-  [[nodiscard]] Hash GetHash() const { return hash_; }
+  [[nodiscard]] Hash GetHash() const { return GetState().hash; }
+
+  /**
+   * \brief Gets hash of the position after the move without doing it.
+   *
+   * \param move Move to do.
+   *
+   * \return Hash of the position after the move.
+   */
+  [[nodiscard]] Hash GetHashAfter(Move move) const;
 
   /**
    * \brief Gets all pieces on the board.
@@ -333,12 +440,56 @@ class Position {
   [[nodiscard]] BitIndex GetKingSquare(Player player) const;
 
   [[nodiscard]] BitIndex GetCastlingRookSquare(
-      Player player, Castling::CastlingSide side) const;
+      Player player, CastlingSide side) const;
 
   [[nodiscard]] Bitboard Attackers(BitIndex square,
                                    Bitboard transparent = kEmptyBoard) const;
 
-  void ComputePins(Player us);
+  /**
+   * \brief Updates checkers, pins and check squares of the position.
+   *
+   * \details DoMove calls it, so it is needed only after the position is set
+   * up piece by piece.
+   */
+  void ComputeCheckInfo();
+
+  /**
+   * \brief Gets the pieces that give check to the side to move.
+   */
+  [[nodiscard]] Bitboard GetCheckers() const;
+
+  /**
+   * \brief Gets the pieces between the king of the player and sliders of the
+   * opponent. Pieces of the player are pinned, pieces of the opponent give a
+   * discovered check when they move off the ray.
+   */
+  [[nodiscard]] Bitboard GetBlockers(Player player) const;
+
+  /**
+   * \brief Gets the squares where the piece of the side to move would give
+   * check.
+   */
+  [[nodiscard]] Bitboard GetCheckSquares(Piece piece) const;
+
+  /**
+   * \brief Gets all squares attacked by the player.
+   *
+   * \details The king of the other player does not block attacks, so it can
+   * not escape a slider by stepping along its ray.
+   *
+   * \param player The attacking player.
+   *
+   * \return Attacked squares.
+   */
+  [[nodiscard]] Bitboard AttackedBy(Player player) const;
+
+  /**
+   * \brief Gets all squares attacked by the opponent of the side to move.
+   *
+   * \details The squares are computed once per position and kept in its
+   * state, so every generation of moves and castling check reuses them.
+   */
+  [[nodiscard]] Bitboard GetEnemyAttacks() const;
 
   [[nodiscard]] bool IsUnderAttack(BitIndex square, Player us,
                                    Bitboard transparent = kEmptyBoard) const;
@@ -357,17 +508,37 @@ class Position {
    */
   [[nodiscard]] bool IsUnderCheck(Player player) const;
 
+  /**
+   * \brief Gets the middle game value of all pieces except pawns and kings.
+   */
+  [[nodiscard]] Eval GetNonPawnMaterial() const;
+
+  /**
+   * \brief Gets the middle game value of pieces of the player except pawns
+   * and the king.
+   */
+  [[nodiscard]] Eval GetNonPawnMaterial(Player player) const;
+
   [[nodiscard]] Eval EstimatePiece(Piece piece) const;
 
   [[nodiscard]] bool StaticExchangeEvaluation(const Move& move,
                                               Eval threshold) const;
 
-  [[nodiscard]] bool DetectRepetition() const {
-    if (history_stack_.history.size() < 3) {
-      return false;
-    }
-    return history_stack_.Count(hash_) >= 3;
-  }
+  [[nodiscard]] bool DetectRepetition() const;
+
+  /**
+   * \brief Checks if the side to move has a move that repeats a position.
+   *
+   * \details Looks up reversible moves between the current position and the
+   * positions of the rule-50 window in the cuckoo table, so no moves are
+   * generated.
+   *
+   * \param ply Distance from the root of the search. Only positions after
+   * the root are taken, so the game is not drawn by the search itself.
+   *
+   * \return True if a position can be repeated by the next move.
+   */
+  [[nodiscard]] bool HasUpcomingRepetition(size_t ply) const;
 
   [[nodiscard]] const std::optional<BitIndex>& GetEnCroissantSquare() const;
 
@@ -375,9 +546,8 @@ class Position {
       const;
 
   template <Piece piece>
-  [[nodiscard]] Bitboard GetCastlingSquares(Castling::CastlingSide side) const;
+  [[nodiscard]] Bitboard GetCastlingSquares(CastlingSide side) const;
 
-  [[nodiscard]] IrreversibleData GetIrreversibleData() const;
   /**
    * \brief Default operator==()
    *
@@ -386,16 +556,21 @@ class Position {
    * \return True if positions are the same, false otherwise.
    */
   bool operator==(const Position& other) const {
-    return std::tie(hash_, side_to_move_, pieces_by_type_, pieces_by_color_,
-                    irreversible_data_) ==
-           std::tie(other.hash_, other.side_to_move_, other.pieces_by_type_,
-                    other.pieces_by_color_, other.irreversible_data_);
+    return std::tie(GetState().hash, side_to_move_, pieces_by_type_,
+                    pieces_by_color_, GetState()) ==
+           std::tie(other.GetState().hash, other.side_to_move_,
+                    other.pieces_by_type_, other.pieces_by_color_,
+                    other.GetState());
   }
 
  private:
+  void ComputePins(Player us);
+
+  [[nodiscard]] StateInfo& GetState() { return states_.Top(); }
+  [[nodiscard]] const StateInfo& GetState() const { return states_.Top(); }
+
   EvaluationData evaluation_data_;
-  IrreversibleData irreversible_data_;
-  GameHistory history_stack_ = {};
+  StateStack states_;
 
   Player side_to_move_{};  //!< Whose side to move.
 
@@ -412,9 +587,6 @@ class Position {
 
   std::array<std::array<Bitboard, 2>, kColors> castling_squares_for_king_{};
   std::array<std::array<Bitboard, 2>, kColors> castling_squares_for_rook_{};
-
-  Hash hash_{};
-  Hasher hasher_{std::mt19937_64(0xb00b1e5)};
 };
 
 inline Bitboard Position::GetAllPieces() const {
@@ -433,7 +605,7 @@ Bitboard Position::GetPiecesByType(const Player player) const {
 }
 
 template <Piece piece>
-Bitboard Position::GetCastlingSquares(Castling::CastlingSide side) const {
+Bitboard Position::GetCastlingSquares(CastlingSide side) const {
   static_assert(piece == Piece::kRook || piece == Piece::kKing);
   if constexpr (piece == Piece::kKing) {
     return castling_squares_for_king_[static_cast<size_t>(side_to_move_)]
@@ -464,7 +636,7 @@ inline BitIndex Position::GetKingSquare(const Player player) const {
 }
 
 inline BitIndex Position::GetCastlingRookSquare(
-    Player player, Castling::CastlingSide side) const {
+    Player player, CastlingSide side) const {
   return rook_positions_[static_cast<size_t>(player)]
                         [static_cast<size_t>(side)];
 }
@@ -478,16 +650,25 @@ inline bool Position::IsUnderAttack(const BitIndex square, const Player us,
 }
 
 inline bool Position::IsUnderCheck() const {
-  return IsUnderCheck(side_to_move_);
+  return GetState().checkers.Any();
 }
 
 inline bool Position::IsUnderCheck(const Player player) const {
   return IsUnderAttack(GetKingSquare(player), player);
 }
 
+inline Eval Position::GetNonPawnMaterial() const {
+  return GetNonPawnMaterial(Player::kWhite) +
+         GetNonPawnMaterial(Player::kBlack);
+}
+
+inline Eval Position::GetNonPawnMaterial(const Player player) const {
+  return evaluation_data_.non_pawn_material[static_cast<size_t>(player)];
+}
+
 inline Eval Position::EstimatePiece(const Piece piece) const {
   const auto piece_type_idx = static_cast<size_t>(piece);
-  return kPieceValues[piece_type_idx](evaluation_data_.non_pawn_material);
+  return kPieceValues[piece_type_idx](GetNonPawnMaterial());
 }
 
 inline bool Position::StaticExchangeEvaluation(const Move& move,
@@ -495,20 +676,19 @@ inline bool Position::StaticExchangeEvaluation(const Move& move,
   const auto us = side_to_move_;
   const auto them = Flip(us);
 
-  const auto [from, to, captured_piece] = GetMoveData(move);
+  const auto from = move.GetFrom();
+  const auto to = move.GetTo();
+  const auto type = move.GetType();
 
-  const auto promotion_or = std::get_if<Promotion>(&move);
+  const auto is_promotion = type == MoveType::kPromotion;
 
-  Piece next_victim =
-      !promotion_or ? GetPiece(from) : promotion_or->promoted_to;
+  Piece next_victim = !is_promotion ? GetPiece(from) : move.GetPromotedTo();
 
-  Eval balance = EstimatePiece(captured_piece);
+  Eval balance = EstimatePiece(GetCapturedPiece(move));
 
-  if (promotion_or) {
+  if (is_promotion) {
     balance +=
-        EstimatePiece(promotion_or->promoted_to) - EstimatePiece(Piece::kPawn);
-  } else if (std::holds_alternative<EnCroissant>(move)) {
-    balance = EstimatePiece(Piece::kPawn);
+        EstimatePiece(move.GetPromotedTo()) - EstimatePiece(Piece::kPawn);
   }
 
   balance -= threshold;
@@ -526,7 +706,7 @@ inline bool Position::StaticExchangeEvaluation(const Move& move,
   Bitboard occupancy =
       GetAllPieces() ^ GetBitboardOfSquare(from) ^ GetBitboardOfSquare(to);
 
-  [[unlikely]] if (std::holds_alternative<EnCroissant>(move)) {
+  [[unlikely]] if (type == MoveType::kEnCroissant) {
     occupancy ^= Shift(GetBitboardOfSquare(to),
                        kPawnMoveDirection[static_cast<size_t>(them)]);
   }
@@ -591,13 +771,24 @@ inline bool Position::StaticExchangeEvaluation(const Move& move,
   return color != GetSideToMove();
 }
 
+inline Piece Position::GetCapturedPiece(const Move move) const {
+  switch (move.GetType()) {
+    case MoveType::kEnCroissant:
+      return Piece::kPawn;
+    case MoveType::kCastling:
+      return Piece::kNone;
+    default:
+      return board_[move.GetTo()];
+  }
+}
+
 inline const std::optional<BitIndex>& Position::GetEnCroissantSquare() const {
-  return irreversible_data_.en_croissant_square;
+  return GetState().en_croissant_square;
 }
 
 inline const std::array<std::bitset<2>, kColors>& Position::GetCastlingRights()
     const {
-  return irreversible_data_.castling_rights;
+  return GetState().castling_rights;
 }
 
 inline Bitboard Position::Attackers(const BitIndex square,
@@ -620,13 +811,78 @@ inline Bitboard Position::Attackers(const BitIndex square,
              pieces_by_type_[static_cast<size_t>(Piece::kKing)];
 }
 
+inline Bitboard Position::AttackedBy(const Player player) const {
+  const auto empty =
+      ~GetAllPieces() | GetBitboardOfSquare(GetKingSquare(Flip(player)));
+  const auto queens = GetPiecesByType<Piece::kQueen>(player);
+
+  return GetAllPawnAttacks(player) |
+         Setwise::GetKnightAttacks(GetPiecesByType<Piece::kKnight>(player)) |
+         AttackTable<Piece::kKing>::GetAttackMap(GetKingSquare(player),
+                                                 kEmptyBoard) |
+         Setwise::GetSlidingAttacks(
+             GetPiecesByType<Piece::kRook>(player) | queens,
+             GetPiecesByType<Piece::kBishop>(player) | queens, empty);
+}
+
+inline Bitboard Position::GetEnemyAttacks() const {
+  auto& enemy_attacks = GetState().enemy_attacks;
+  if (!enemy_attacks) {
+    enemy_attacks = AttackedBy(Flip(side_to_move_));
+  }
+  return *enemy_attacks;
+}
+
+inline void Position::ComputeCheckInfo() {
+  const auto us = side_to_move_;
+  const auto them = Flip(us);
+
+  // the pieces have moved, the attacks are found again on request
+  GetState().enemy_attacks.reset();
+
+  ComputePins(us);
+  ComputePins(them);
+
+  GetState().checkers =
+      Attackers(GetKingSquare(us)) & GetPieces(them);
+
+  const auto king_square = GetKingSquare(them);
+  const auto occupancy = GetAllPieces();
+  const auto diagonal =
+      AttackTable<Piece::kBishop>::GetAttackMap(king_square, occupancy);
+  const auto straight =
+      AttackTable<Piece::kRook>::GetAttackMap(king_square, occupancy);
+
+  auto& check_squares = GetState().check_squares;
+  check_squares[static_cast<size_t>(Piece::kPawn)] =
+      GetPawnAttacks(king_square, them);
+  check_squares[static_cast<size_t>(Piece::kKnight)] =
+      AttackTable<Piece::kKnight>::GetAttackMap(king_square, occupancy);
+  check_squares[static_cast<size_t>(Piece::kBishop)] = diagonal;
+  check_squares[static_cast<size_t>(Piece::kRook)] = straight;
+  check_squares[static_cast<size_t>(Piece::kQueen)] = diagonal | straight;
+  check_squares[static_cast<size_t>(Piece::kKing)] = kEmptyBoard;
+}
+
+inline Bitboard Position::GetCheckers() const {
+  return GetState().checkers;
+}
+
+inline Bitboard Position::GetBlockers(const Player player) const {
+  return GetState().blockers[static_cast<size_t>(player)];
+}
+
+inline Bitboard Position::GetCheckSquares(const Piece piece) const {
+  return GetState().check_squares[static_cast<size_t>(piece)];
+}
+
 inline void Position::ComputePins(const Player us) {
   const Player them = Flip(us);
 
   const auto us_idx = static_cast<size_t>(us);
 
-  irreversible_data_.blockers[us_idx] = kEmptyBoard;
-  irreversible_data_.pinners[us_idx] = kEmptyBoard;
+  GetState().blockers[us_idx] = kEmptyBoard;
+  GetState().pinners[us_idx] = kEmptyBoard;
 
   const BitIndex king_square = GetKingSquare(us);
 
@@ -651,9 +907,9 @@ inline void Position::ComputePins(const Player us) {
        GetPiecesByType<Piece::kQueen>(them)) &
       ~straight_blockers;
 
-  irreversible_data_.pinners[us_idx] = diagonal_pinners | straight_pinners;
+  GetState().pinners[us_idx] = diagonal_pinners | straight_pinners;
 
-  Bitboard& blockers = irreversible_data_.blockers[us_idx];
+  Bitboard& blockers = GetState().blockers[us_idx];
   while (diagonal_pinners.Any()) {
     const BitIndex square = diagonal_pinners.PopFirstBit();
 
@@ -672,7 +928,16 @@ inline void Position::ComputePins(const Player us) {
   }
 }
 
-inline Position::IrreversibleData Position::GetIrreversibleData() const {
-  return irreversible_data_;
+inline bool Position::DetectRepetition() const {
+  const auto hash = GetHash();
+  const auto depth =
+      std::min(GetState().rule50, GetState().plies_from_null);
+
+  // only positions with the same side to move can repeat
+  size_t count = 1;
+  for (size_t plies = 2; plies <= depth; plies += 2) {
+    count += states_.Back(plies).hash == hash;
+  }
+  return count >= 3;
 }
 }  // namespace SimpleChessEngine
\ No newline at end of file
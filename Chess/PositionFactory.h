@@ -130,6 +130,8 @@ inline Position PositionFactory::operator()(const std::string& fen) const
         rook_between[rooks[1][1]][kRookCastlingDestination[1][1]]}}};
   position.SetCastlingSquares(cs_king, cs_rook);
 
+  position.ComputeCheckInfo();
+
   return position;
 }
 
@@ -1,23 +1,34 @@
 #pragma once
+#include <algorithm>
+#include <tuple>
+
 #include "Concepts.h"
 #include "Evaluation.h"
 #include "MoveGenerator.h"
 #include "Position.h"
+#include "TranspositionTable.h"
 
 namespace SimpleChessEngine {
-template <class ExitCondition>
-  requires StopSearchCondition<ExitCondition>
+/**
+ * \brief Search of captures at the leaves of the main search.
+ *
+ * \details One object serves all leaves of a searcher, so its node counter
+ * runs through the whole search and the time is checked as often as in the
+ * main search.
+ */
 class Quiescence {
  public:
   constexpr static size_t kEnoughNodesToCheckTime = 1 << 12;
   constexpr static Eval kSEEMargin = 120;
+  constexpr static Eval kDeltaMargin = kSEEMargin;
 
   /**
    * \brief Constructor.
    *
+   * \param transposition_table Transposition-table shared between searchers.
    */
-  Quiescence(const ExitCondition& exit_condition)
-      : exit_condition_(exit_condition){};
+  explicit Quiescence(TranspositionTable& transposition_table)
+      : transposition_table_(transposition_table){};
 
   /**
    * \brief Performs the alpha-beta search algorithm.
@@ -25,67 +36,120 @@ class Quiescence {
    * \param current_position Current position.
    * \param alpha The current alpha value.
    * \param beta The current beta value.
+   * \param exit_condition Condition to stop the search.
    *
-   * \return Evaluation of subtree.
+   * \return Evaluation of subtree or nullopt if the search was stopped.
    */
-  template <bool start_of_search>
+  template <StopSearchCondition ExitCondition>
   [[nodiscard]] SearchResult Search(Position& current_position, Eval alpha,
-                                    Eval beta);
+                                    Eval beta,
+                                    const ExitCondition& exit_condition);
 
-  [[nodiscard]] SearchResult SearchUnderCheck(Position& current_position,
-                                              Eval alpha, Eval beta);
+  template <StopSearchCondition ExitCondition>
+  [[nodiscard]] SearchResult SearchUnderCheck(
+      Position& current_position, Eval alpha, Eval beta,
+      const ExitCondition& exit_condition);
 
   [[nodiscard]] std::size_t GetSearchedNodes() const { return searched_nodes_; }
 
+  void ClearSearchedNodes() { searched_nodes_ = 0; }
+
  private:
   bool CompareMoves(const Move& lhs, const Move& rhs,
                     const Position& current_position) const {
-    if (lhs.index() != rhs.index()) return lhs.index() > rhs.index();
-    if (!std::holds_alternative<DefaultMove>(lhs)) return false;
-    const auto [from_lhs, to_lhs, captured_piece_lhs] = GetMoveData(lhs);
-    const auto [from_rhs, to_rhs, captured_piece_rhs] = GetMoveData(rhs);
-    const auto captured_idx_lhs = static_cast<int>(captured_piece_lhs);
-    const auto captured_idx_rhs = static_cast<int>(captured_piece_rhs);
-    const auto moving_idx_lhs =
-        -static_cast<int>(current_position.GetPiece(from_lhs));
-    const auto moving_idx_rhs =
-        -static_cast<int>(current_position.GetPiece(from_rhs));
-    return std::tie(captured_idx_lhs, moving_idx_lhs) >
-           std::tie(captured_idx_rhs, moving_idx_rhs);
+    // promotions first, then captures by MVV-LVA
+    const auto key = [&current_position](const Move move) {
+      return std::tuple{
+          move.GetType() == MoveType::kPromotion,
+          static_cast<int>(current_position.GetCapturedPiece(move)),
+          -static_cast<int>(current_position.GetPiece(move.GetFrom()))};
+    };
+    return key(lhs) > key(rhs);
   }
 
-  bool IsTimeToExit() {
+  /**
+   * \brief Checks if the capture can not bring the score up to alpha, even
+   * if the capturing piece is not taken back.
+   *
+   * \details It is a cheap filter before the static exchange evaluation,
+   * which fails for these captures anyway.
+   */
+  [[nodiscard]] static bool IsFutileCapture(const Move& move,
+                                            const Position& current_position,
+                                            const Eval stand_pat,
+                                            const Eval alpha) {
+    if (move.GetType() == MoveType::kPromotion) {
+      return false;
+    }
+    const auto gain = current_position.EstimatePiece(
+        current_position.GetCapturedPiece(move));
+    return stand_pat + gain + kDeltaMargin < alpha;
+  }
+
+  bool IsTimeToExit(const StopSearchCondition auto& exit_condition) const {
     return searched_nodes_ % kEnoughNodesToCheckTime == 0 &&
-           exit_condition_.IsTimeToExit();
+           exit_condition.IsTimeToExit();
   }
 
   MoveGenerator move_generator_;  //!< Move generator.
 
-  const ExitCondition& exit_condition_;
+  TranspositionTable& transposition_table_;
 
   std::size_t searched_nodes_{};
 };
 
-template <class ExitCondition>
-  requires StopSearchCondition<ExitCondition>
-template <bool start_of_search>
-SearchResult Quiescence<ExitCondition>::Search(Position& current_position,
-                                               Eval alpha, const Eval beta) {
-  if constexpr (start_of_search) {
-    searched_nodes_ = 0;
-  }
+template <StopSearchCondition ExitCondition>
+SearchResult Quiescence::Search(Position& current_position, Eval alpha,
+                                const Eval beta,
+                                const ExitCondition& exit_condition) {
   searched_nodes_++;
 
+  if (IsTimeToExit(exit_condition)) {
+    return std::nullopt;
+  }
+
+  const auto entry = transposition_table_.Probe(current_position);
+
+  // every entry is at least as deep as the quiescence search, but mate
+  // scores depend on the ply, which is unknown here
+  if (entry && !IsMateScore(entry->score)) {
+    if (entry->bound & Bound::kLower && entry->score >= beta) {
+      return beta;
+    }
+    if (entry->bound & Bound::kUpper && entry->score <= alpha) {
+      return alpha;
+    }
+    if (entry->bound == Bound::kExact) {
+      return entry->score;
+    }
+  }
+
   if (current_position.IsUnderCheck()) {
-    return SearchUnderCheck(current_position, alpha, beta);
+    return SearchUnderCheck(current_position, alpha, beta, exit_condition);
   }
 
-  const auto stand_pat = current_position.Evaluate();
+  // every writer stores the plain Evaluate() of the position as the static
+  // evaluation, in check or not, so any entry gives the stand pat
+  const auto stand_pat =
+      entry ? entry->static_eval : current_position.Evaluate();
+
+  // results of the main search are not replaced by shallower ones, mate
+  // bounds come from evasions that are scored without the ply and so are
+  // not stored at all
+  const auto store = [&](const Move& best_move, const Eval score,
+                         const Bound bound) {
+    if ((!entry || entry->depth == 0) && !IsMateScore(score)) {
+      transposition_table_.SetEntry(current_position, best_move, score, 0,
+                                    bound, stand_pat);
+    }
+  };
 
   if (stand_pat >= beta) {
+    store(Move{}, beta, Bound::kLower);
     return beta;
   }
 
+  const auto original_alpha = alpha;
   if (alpha < stand_pat) {
     alpha = stand_pat;
   }
@@ -99,28 +163,40 @@ SearchResult Quiescence<ExitCondition>::Search(Position& current_position,
         return CompareMoves(lhs, rhs, current_position);
       });
 
+  // the hash move is tried first
+  if (entry) {
+    if (const auto it = std::ranges::find(moves, entry->move);
+        it != moves.end()) {
+      std::rotate(moves.begin(), it, it + 1);
+    }
+  }
+
+  Move best_move{};
   for (const auto& move : moves) {
-    if (!current_position.StaticExchangeEvaluation(
+    if (IsFutileCapture(move, current_position, stand_pat, alpha) ||
+        !current_position.StaticExchangeEvaluation(
             move, std::max(1, alpha - stand_pat - kSEEMargin))) {
       continue;
     }
 
-    const auto irreversible_data = current_position.GetIrreversibleData();
+    transposition_table_.Prefetch(current_position.GetHashAfter(move));
 
     // make the move and search the tree
     current_position.DoMove(move);
     const auto temp_eval_optional =
-        Search<false>(current_position, -beta, -alpha);
+        Search(current_position, -beta, -alpha, exit_condition);
 
     if (!temp_eval_optional) return std::nullopt;
 
     const auto temp_eval = -*temp_eval_optional;
 
     // undo the move
-    current_position.UndoMove(move, irreversible_data);
+    current_position.UndoMove(move);
 
     if (temp_eval > alpha) {
+      best_move = move;
       if (temp_eval >= beta) {
+        store(best_move, beta, Bound::kLower);
         return beta;
       }
 
@@ -128,15 +204,17 @@ SearchResult Quiescence<ExitCondition>::Search(Position& current_position,
     }
   }
 
+  store(best_move, alpha,
+        alpha > original_alpha ? Bound::kExact : Bound::kUpper);
   return alpha;
 }
 
-template <class ExitCondition>
-  requires StopSearchCondition<ExitCondition>
-inline SearchResult Quiescence<ExitCondition>::SearchUnderCheck(
-    Position& current_position, Eval alpha, Eval beta) {
+template <StopSearchCondition ExitCondition>
+inline SearchResult Quiescence::SearchUnderCheck(
+    Position& current_position, Eval alpha, Eval beta,
+    const ExitCondition& exit_condition) {
   MoveGenerator::Moves moves =
-      move_generator_.GenerateMoves<MoveGenerator::Type::kDefault>(
+      move_generator_.GenerateMoves<MoveGenerator::Type::kEvasions>(
           current_position);
 
   if (moves.empty()) {
@@ -149,19 +227,17 @@ inline SearchResult Quiescence<ExitCondition>::SearchUnderCheck(
       });
 
   for (const auto& move : moves) {
-    const auto irreversible_data = current_position.GetIrreversibleData();
-
     // make the move and search the tree
     current_position.DoMove(move);
     const auto temp_eval_optional =
-        Search<false>(current_position, -beta, -alpha);
+        Search(current_position, -beta, -alpha, exit_condition);
 
     if (!temp_eval_optional) return std::nullopt;
 
     const auto temp_eval = -*temp_eval_optional;
 
     // undo the move
-    current_position.UndoMove(move, irreversible_data);
+    current_position.UndoMove(move);
 
     if (temp_eval > alpha) {
       if (temp_eval >= beta) {
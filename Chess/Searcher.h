@@ -1,11 +1,12 @@
 #pragma once
 #include <algorithm>
 #include <array>
+#include <cmath>
 
 #include "Concepts.h"
 #include "Evaluation.h"
-#include "KillerTable.h"
 #include "MoveGenerator.h"
+#include "MovePicker.h"
 #include "PositionFactory.h"
 #include "Quiescence.h"
 #include "StreamUtility.h"
@@ -20,8 +21,12 @@ namespace SimpleChessEngine {
  *  - PVS
  *  - ZWS
  *  - Fail-soft
+ *  - Null move pruning
+ *  - Late move reductions
+ *  - Futility, late move and SEE pruning
  *  - Aspiration windows
  *  - Transposition table
+ *  - Staged move picking
  *  - Iterative deepening
  *  - Quiescence search
  *
@@ -29,13 +34,6 @@ namespace SimpleChessEngine {
  */
 class Searcher {
  public:
-#ifdef _DEBUG
-  constexpr static size_t kTTsize = 1 << 10;
-#else
-  constexpr static size_t kTTsize = 1 << 26;
-#endif
-  using TranspositionTable = TranspositionTable<kTTsize>;
-
   struct DebugInfo {
     std::size_t searched_nodes{};
     std::size_t quiescence_nodes{};
@@ -52,10 +50,14 @@ class Searcher {
   /**
    * \brief Constructor.
    *
+   * \param transposition_table Transposition-table shared between searchers.
    * \param position The initial position.
    */
-  explicit Searcher(Position position = PositionFactory{}())
-      : current_position_(std::move(position)) {}
+  explicit Searcher(TranspositionTable &transposition_table,
+                    Position position = PositionFactory{}())
+      : current_position_(std::move(position)),
+        best_moves_(transposition_table),
+        quiescence_(transposition_table) {}
 
   /**
    * \brief Sets the current position.
@@ -93,7 +95,19 @@ class Searcher {
       const StopSearchCondition auto &stop_search_condition, Depth max_depth,
       Depth remaining_depth, Eval alpha, Eval beta);
 
-  [[nodiscard]] const DebugInfo &GetInfo() const { return debug_info_; }
+  [[nodiscard]] DebugInfo GetInfo() const {
+    auto info = debug_info_;
+    info.quiescence_nodes = quiescence_.GetSearchedNodes();
+    return info;
+  }
+
+  /**
+   * \brief Resets the counters, searches of the root add up to them.
+   */
+  void ClearInfo() {
+    debug_info_ = DebugInfo{};
+    quiescence_.ClearSearchedNodes();
+  }
 
   [[nodiscard]] std::size_t GetSearchedNodes() const {
     return debug_info_.searched_nodes;
@@ -110,10 +124,12 @@ class Searcher {
       Depth max_depth, Position position) const {
     MoveGenerator::Moves answer;
     for (Depth i = 0; i < max_depth; ++i) {
-      const auto &hashed_node = best_moves_.GetNode(position);
-      if (hashed_node.true_hash != position.GetHash()) break;
-      position.DoMove(hashed_node.move);
-      answer.push_back(hashed_node.move);
+      const auto hashed_node = best_moves_.Probe(position);
+      if (!hashed_node || hashed_node->move == Move{} ||
+          !position.IsLegal(hashed_node->move))
+        break;
+      position.DoMove(hashed_node->move);
+      answer.push_back(hashed_node->move);
     }
     return answer;
   }
@@ -124,6 +140,7 @@ class Searcher {
   struct SearchStatus {
     Depth max_depth;
     Depth remaining_depth;
+    Depth ply;  //!< Distance from the root, reductions do not change it.
     Eval alpha = {};
     Eval beta;
   };
@@ -151,13 +168,11 @@ class Searcher {
     const ExitCondition &exit_condition_;
 
     /* Local variables for search */
-    bool has_stored_move = false;
     bool has_raised_alpha = false;
     Move best_move;
     Eval best_eval = {};
-    const Eval static_eval;
+    Eval static_eval = {};
     const bool is_under_check = false;
-    const Position::IrreversibleData irreversible_data;
     const size_t side_to_move_idx;
 
     SearchResult QuiescenceSearch();
@@ -168,28 +183,58 @@ class Searcher {
 
     void SetTTEntry(const Bound bound);
 
+    void PrefetchChild(const Move &move) const;
+
     template <bool is_pv_move>
     SearchResult ProbeMove(const Move &move);
 
     template <bool is_pv_move>
     std::optional<bool> CheckFirstMove(const Move &move);
 
-    struct QuietRange {
-      MoveGenerator::Moves::iterator quiet_begin;
-      MoveGenerator::Moves::iterator quiet_end;
-    };
-
-    QuietRange OrderMoves(const MoveGenerator::Moves::iterator first,
-                          const MoveGenerator::Moves::iterator last);
-
-    SearchResult PVSearch(const MoveGenerator::Moves::iterator first,
-                          const MoveGenerator::Moves::iterator last,
-                          const QuietRange &ordeing_result);
+    SearchResult PVSearch(MovePicker &move_picker);
 
     void UpdateQuietMove(const Move &move);
 
+    /**
+     * \brief Gets the reduction of a move that is searched after the first
+     * one.
+     *
+     * \param move_picker Picker that gave the move.
+     * \param move The move.
+     * \param move_index Index of the move in the order of search.
+     * \param gives_check True if the move gives check.
+     *
+     * \return The reduction, it leaves at least one ply to search.
+     */
+    [[nodiscard]] Depth GetReduction(const MovePicker &move_picker,
+                                     const Move &move, std::size_t move_index,
+                                     bool gives_check) const;
+
     [[nodiscard]] bool CanRFP() const;
 
+    /**
+     * \brief Checks if a move after the first one can be skipped.
+     *
+     * \param move The move.
+     * \param move_index Index of the move in the order of search.
+     * \param gives_check True if the move gives check.
+     *
+     * \return True if the move is unlikely to raise alpha.
+     */
+    [[nodiscard]] bool CanPruneMove(const Move &move, std::size_t move_index,
+                                    bool gives_check) const;
+
+    [[nodiscard]] bool CanNullMove() const;
+
+    /**
+     * \brief Searches the position after passing the turn with a reduced
+     * depth.
+     *
+     * \return Score of the null move search, it is verified by a reduced
+     * search without null moves at high depths.
+     */
+    SearchResult NullMoveSearch();
+
     Searcher &searcher_;
 
     struct PruneParameters {
@@ -198,31 +243,78 @@ class Searcher {
         static constexpr Depth depth_limit = 5;
         static constexpr Eval threshold = 75;
       };
+      struct fp {
+        static constexpr bool enabled = true;
+        static constexpr Depth depth_limit = 6;
+        static constexpr Eval base_margin = 100;
+        static constexpr Eval depth_margin = 100;
+      };
+      struct lmp {
+        static constexpr bool enabled = true;
+        static constexpr Depth depth_limit = 6;
+        static constexpr std::size_t base_move_count = 3;
+      };
+      struct see {
+        static constexpr bool enabled = true;
+        static constexpr Depth depth_limit = 8;
+        static constexpr Eval quiet_margin = 60;
+        static constexpr Eval capture_margin = 25;
+      };
+      struct lmr {
+        static constexpr bool enabled = true;
+        static constexpr Depth min_depth = 3;
+        static constexpr std::size_t min_move_index = 2;
+      };
+      struct nmp {
+        static constexpr bool enabled = true;
+        static constexpr Depth min_depth = 3;
+        static constexpr Depth base_reduction = 3;
+        static constexpr Depth depth_divisor = 4;
+        static constexpr Depth verification_depth = 12;
+      };
     };
   };
 
-  std::pair<MoveGenerator::Moves::iterator, MoveGenerator::Moves::iterator>
-  OrderMoves(const MoveGenerator::Moves::iterator first,
-             const MoveGenerator::Moves::iterator last, const Depth ply,
-             const Player color) const;
-  Age age_{};
+  using ReductionTable =
+      std::array<std::array<Depth, kMaxMovesPerPosition>, kMaxSearchPly>;
+
+  /**
+   * \brief Base reductions of late moves by the remaining depth and the index
+   * of the move, they grow with logarithms of both.
+   */
+  static inline const ReductionTable kReductions = [] {
+    constexpr double kBase = 0.75;
+    constexpr double kDivisor = 2.25;
+
+    ReductionTable reductions{};
+    for (std::size_t depth = 1; depth < kMaxSearchPly; ++depth) {
+      for (std::size_t index = 1; index < kMaxMovesPerPosition; ++index) {
+        reductions[depth][index] = static_cast<Depth>(
+            kBase + std::log(static_cast<double>(depth)) *
+                        std::log(static_cast<double>(index)) / kDivisor);
+      }
+    }
+    return reductions;
+  }();
 
   Move best_move_{};
 
   Position current_position_;  //!< Current position.
 
-  MoveGenerator move_generator_;  //!< Move generator.
-
   TranspositionTable
-      best_moves_;  //!< Transposition-table to store the best moves.
+      &best_moves_;  //!< Transposition-table to store the best moves.
 
-  std::array<std::array<std::array<uint64_t, kBoardArea + 1>, kBoardArea + 1>,
-             kColors>
-      history_ = {};
+  std::array<MovePicker::History, kColors> history_ = {};
 
-  KillerTable<2> killers_;
+  MovePicker::Killers killers_;
+
+  //! Null moves are not tried before this ply while a null move is verified.
+  Depth null_move_min_ply_ = 0;
 
   DebugInfo debug_info_;
+
+  //! Searches the leaves, it counts its own nodes.
+  Quiescence quiescence_;
 };
 }  // namespace SimpleChessEngine
 
@@ -239,9 +331,10 @@ inline const Move &Searcher::GetCurrentBestMove() const { return best_move_; }
 
 inline void Searcher::InitStartOfSearch() {
   killers_.Clear();
+  null_move_min_ply_ = 0;
   for (unsigned color = 0; color < kColors; ++color) {
-    for (BitIndex from = 0; from <= kBoardArea; ++from) {
-      for (BitIndex to = 0; to <= kBoardArea; ++to) {
+    for (BitIndex from = 0; from < kBoardArea; ++from) {
+      for (BitIndex to = 0; to < kBoardArea; ++to) {
         history_[color][from][to] = 0ull;
       }
     }
@@ -252,73 +345,14 @@ template <bool is_principal_variation>
 inline SearchResult SimpleChessEngine::Searcher::Search(
     const StopSearchCondition auto &stop_search_condition, Depth max_depth,
     Depth remaining_depth, Eval alpha, Eval beta) {
-  debug_info_ = DebugInfo{};
-
-  ++age_;
-
   return SearchImplementation<is_principal_variation,
                               decltype(stop_search_condition)>{
       *this,
-      {max_depth, remaining_depth, alpha, beta},
+      {max_depth, remaining_depth,
+       static_cast<Depth>(max_depth - remaining_depth), alpha, beta},
       stop_search_condition}();
 }
 
-inline std::pair<MoveGenerator::Moves::iterator, MoveGenerator::Moves::iterator>
-Searcher::OrderMoves(const MoveGenerator::Moves::iterator first,
-                     const MoveGenerator::Moves::iterator last, const Depth ply,
-                     const Player color) const {
-  auto color_idx = static_cast<size_t>(color);
-  MoveGenerator::Moves::iterator quiet_begin;
-  quiet_begin = std::partition(first, last, [this](const Move &move) {
-    if (std::holds_alternative<Promotion>(move) ||
-        std::holds_alternative<EnCroissant>(move))
-      return true;
-    if (!std::holds_alternative<DefaultMove>(move)) return false;
-    const auto [from, to, captured_piece] = std::get<DefaultMove>(move);
-    return static_cast<size_t>(captured_piece) >=
-           static_cast<size_t>(current_position_.GetPiece(from));
-  });
-  MoveGenerator::Moves::iterator quiet_end;
-  quiet_end = std::partition(quiet_begin, last, [](const Move &move) {
-    if (!std::holds_alternative<DefaultMove>(move)) return true;
-    const auto [from, to, captured_piece] = std::get<DefaultMove>(move);
-    return !captured_piece;
-  });
-  const auto CompareCaptures = [this](const Move &lhs, const Move &rhs) {
-    const auto [from_lhs, to_lhs, captured_piece_lhs] = GetMoveData(lhs);
-    const auto [from_rhs, to_rhs, captured_piece_rhs] = GetMoveData(rhs);
-    const auto captured_idx_lhs = static_cast<int>(captured_piece_lhs);
-    const auto captured_idx_rhs = static_cast<int>(captured_piece_rhs);
-    const auto moving_idx_lhs =
-        -static_cast<int>(current_position_.GetPiece(from_lhs));
-    const auto moving_idx_rhs =
-        -static_cast<int>(current_position_.GetPiece(from_rhs));
-    return std::tie(captured_idx_lhs, moving_idx_lhs) >
-           std::tie(captured_idx_rhs, moving_idx_rhs);
-  };
-  std::sort(first, quiet_begin, CompareCaptures);
-  std::sort(quiet_end, last, CompareCaptures);
-  int increment = 0;
-  for (size_t i = 0; i < killers_.AvailableKillerCount(ply); ++i) {
-    const auto killer = killers_.Get(ply, i);
-    if (auto it = std::find(quiet_begin, quiet_end, killer); it != quiet_end) {
-      std::iter_swap(quiet_begin, it);
-      ++quiet_begin;
-      ++increment;
-    }
-  }
-  const auto CompareQuiet = [this, color_idx](const Move &lhs,
-                                              const Move &rhs) {
-    const auto [from_lhs, to_lhs, captured_piece_lhs] = GetMoveData(lhs);
-    const auto [from_rhs, to_rhs, captured_piece_rhs] = GetMoveData(rhs);
-    return history_[color_idx][from_lhs][to_lhs] >
-           history_[color_idx][from_rhs][to_rhs];
-  };
-  std::sort(quiet_begin - increment, quiet_begin, CompareQuiet);
-  std::sort(quiet_begin, quiet_end, CompareQuiet);
-  std::advance(quiet_begin, -increment);
-  return {quiet_begin, quiet_end};
-}
 template <bool is_principal_variation, class ExitCondition>
   requires StopSearchCondition<ExitCondition>
 inline SimpleChessEngine::Searcher::SearchImplementation<
@@ -328,8 +362,6 @@ inline SimpleChessEngine::Searcher::SearchImplementation<
                                          const ExitCondition &exit_condition)
     : status_(status),
       exit_condition_(exit_condition),
-      static_eval(searcher.current_position_.Evaluate()),
-      irreversible_data(searcher.current_position_.GetIrreversibleData()),
       side_to_move_idx(
           static_cast<size_t>(searcher.current_position_.GetSideToMove())),
       is_under_check(searcher.current_position_.IsUnderCheck()),
@@ -364,11 +396,20 @@ inline SearchResult SimpleChessEngine::Searcher::SearchImplementation<
     return kDrawValue;
   }
 
-  auto &[max_depth, remaining_depth, alpha, beta] = status_;
+  auto &[max_depth, remaining_depth, ply, alpha, beta] = status_;
+
+  // a line that can be repeated by the next move is at least a draw
+  if (ply != 0 && alpha < kDrawValue &&
+      searcher_.current_position_.HasUpcomingRepetition(ply)) {
+    alpha = kDrawValue;
+    if (alpha >= beta) {
+      return alpha;
+    }
+  }
 
   if constexpr (is_principal_variation) {
     if (remaining_depth <= 1) {
-      return Search<false>({max_depth, remaining_depth, alpha, beta});
+      return Search<false>({max_depth, remaining_depth, ply, alpha, beta});
     }
   }
 
@@ -380,17 +421,32 @@ inline SearchResult SimpleChessEngine::Searcher::SearchImplementation<
 
   searcher_.debug_info_.searched_nodes++;
 
-  if (auto [hash, hash_move, entry_score, entry_depth, entry_bound, _] =
-          searcher_.best_moves_.GetNode(searcher_.current_position_);
-      hash == searcher_.current_position_
-                  .GetHash()) {  // check if current position was previously
-                                 // searched at higher depth
+  // check if current position was previously searched at higher depth
+  const auto entry = searcher_.best_moves_.Probe(searcher_.current_position_);
+
+  // the static evaluation of a known position is stored in its entry
+  static_eval =
+      entry ? entry->static_eval : searcher_.current_position_.Evaluate();
+
+  // the hash move is the first picked move, it is tried before generation
+  MovePicker move_picker{searcher_.current_position_,
+                         entry && entry->move != Move{}
+                             ? std::optional{entry->move}
+                             : std::nullopt,
+                         searcher_.killers_, ply,
+                         searcher_.history_[side_to_move_idx]};
+
+  if (entry) {
+    const auto &hash_move = entry->move;
+    const auto entry_depth = entry->depth;
+    const Bound entry_bound = entry->bound;
+    auto entry_score = entry->score;
 
-    if (remaining_depth == max_depth) {
+    if (ply == 0 && hash_move != Move{}) {
       searcher_.best_move_ = hash_move;
     }
 
-    entry_score -= IsMateScore(entry_score) * (max_depth - remaining_depth);
+    entry_score -= IsMateScore(entry_score) * ply;
 
     if (!is_principal_variation && entry_depth >= remaining_depth) {
       if (entry_bound & Bound::kUpper && entry_score <= alpha) {
@@ -398,7 +454,7 @@ inline SearchResult SimpleChessEngine::Searcher::SearchImplementation<
       }
       if (entry_bound & Bound::kLower && entry_score > alpha) {
         if (entry_score >= beta) {
-          if (IsQuiet(hash_move)) {
+          if (searcher_.current_position_.IsQuiet(hash_move)) {
             UpdateQuietMove(hash_move);
           }
           return beta;
@@ -410,15 +466,6 @@ inline SearchResult SimpleChessEngine::Searcher::SearchImplementation<
         return entry_score;
       }
     }
-    auto has_cutoff_opt = CheckFirstMove<is_principal_variation>(hash_move);
-    if (!has_cutoff_opt) {
-      return std::nullopt;
-    }
-    if (*has_cutoff_opt) {
-      SetTTEntry(Bound::kLower);
-      return beta;
-    }
-    has_stored_move = true;
   }
 
   if constexpr (PruneParameters::rfp::enabled) {
@@ -427,53 +474,55 @@ inline SearchResult SimpleChessEngine::Searcher::SearchImplementation<
     }
   }
 
-  auto const &move_generator = searcher_.move_generator_;
-  auto &current_position = searcher_.current_position_;
+  if constexpr (PruneParameters::nmp::enabled) {
+    if (CanNullMove()) {
+      const auto null_eval = NullMoveSearch();
+      if (!null_eval) {
+        return std::nullopt;
+      }
+      if (*null_eval >= beta) {
+        return beta;
+      }
+    }
+  }
 
-  auto moves = move_generator.GenerateMoves<MoveGenerator::Type::kDefault>(
-      current_position);
+  // the picker gives the hash move first, if it can be played here
+  const auto first_move = move_picker.SelectNextMove();
 
   // check if there are no possible moves
-  if (moves.empty()) {
+  if (!first_move) {
     return GetEndGameScore();
   }
 
-  const auto ordering_result = OrderMoves(moves.begin(), moves.end());
-
-  if (!has_stored_move) {
-    auto has_cutoff_opt = CheckFirstMove<false>(moves.front());
-    if (!has_cutoff_opt) {
-      return std::nullopt;
-    }
-    if (*has_cutoff_opt) {
-      SetTTEntry(Bound::kLower);
-      return beta;
-    }
+  const auto has_cutoff_opt =
+      entry && *first_move == entry->move
+          ? CheckFirstMove<is_principal_variation>(*first_move)
+          : CheckFirstMove<false>(*first_move);
+  if (!has_cutoff_opt) {
+    return std::nullopt;
+  }
+  if (*has_cutoff_opt) {
+    SetTTEntry(Bound::kLower);
+    return beta;
   }
 
-  return PVSearch(std::next(moves.begin()), moves.end(), ordering_result);
+  return PVSearch(move_picker);
 }
 
 template <bool is_principal_variation, class ExitCondition>
   requires StopSearchCondition<ExitCondition>
 inline SearchResult SimpleChessEngine::Searcher::SearchImplementation<
     is_principal_variation, ExitCondition>::QuiescenceSearch() {
-  auto &current_position = searcher_.current_position_;
-  auto quiescence_searcher = Quiescence{exit_condition_};
-
-  const auto eval = quiescence_searcher.template Search<true>(
-      current_position, status_.alpha, status_.beta);
-  searcher_.debug_info_.quiescence_nodes +=
-      quiescence_searcher.GetSearchedNodes();
-  return eval;
+  return searcher_.quiescence_.Search(searcher_.current_position_,
+                                      status_.alpha, status_.beta,
+                                      exit_condition_);
 }
 template <bool is_principal_variation, class ExitCondition>
   requires StopSearchCondition<ExitCondition>
 inline Eval SimpleChessEngine::Searcher::SearchImplementation<
     is_principal_variation, ExitCondition>::GetEndGameScore() const {
   if (is_under_check) {
-    return kMateValue +
-           static_cast<Eval>(status_.max_depth - status_.remaining_depth);
+    return kMateValue + static_cast<Eval>(status_.ply);
   }
   return kDrawValue;
 }
@@ -486,7 +535,7 @@ inline void SimpleChessEngine::Searcher::SearchImplementation<
 
   best_move = move;
 
-  if (status_.remaining_depth == status_.max_depth) {
+  if (status_.ply == 0) {
     searcher_.best_move_ = move;
   }
 }
@@ -497,9 +546,17 @@ inline void SimpleChessEngine::Searcher::SearchImplementation<
     is_principal_variation, ExitCondition>::SetTTEntry(const Bound bound) {
   searcher_.best_moves_.SetEntry(
       searcher_.current_position_, best_move,
-      best_eval + IsMateScore(best_eval) *
-                      (status_.max_depth - status_.remaining_depth),
-      status_.remaining_depth, bound, searcher_.age_);
+      best_eval + IsMateScore(best_eval) * status_.ply,
+      status_.remaining_depth, bound, static_eval);
+}
+template <bool is_principal_variation, class ExitCondition>
+  requires StopSearchCondition<ExitCondition>
+inline void SimpleChessEngine::Searcher::SearchImplementation<
+    is_principal_variation, ExitCondition>::PrefetchChild(const Move &move)
+    const {
+  // leaves of the main search probe the table in the quiescence search
+  searcher_.best_moves_.Prefetch(
+      searcher_.current_position_.GetHashAfter(move));
 }
 template <bool is_principal_variation, class ExitCondition>
   requires StopSearchCondition<ExitCondition>
@@ -507,19 +564,21 @@ template <bool is_pv_move>
 inline SearchResult Searcher::SearchImplementation<
     is_principal_variation, ExitCondition>::ProbeMove(const Move &move) {
   auto &current_position = searcher_.current_position_;
+  auto &[max_depth, remaining_depth, ply, alpha, beta] = status_;
+
+  PrefetchChild(move);
 
   // make the move and search the tree
   current_position.DoMove(move);
 
-  auto &[max_depth, remaining_depth, alpha, beta] = status_;
-
-  const auto eval_optional = Search<is_pv_move>(
-      {max_depth, static_cast<Depth>(remaining_depth - 1), -beta, -alpha});
+  const auto eval_optional =
+      Search<is_pv_move>({max_depth, static_cast<Depth>(remaining_depth - 1),
+                          static_cast<Depth>(ply + 1), -beta, -alpha});
 
   if (!eval_optional) return std::nullopt;
 
   // undo the move
-  current_position.UndoMove(move, irreversible_data);
+  current_position.UndoMove(move);
 
   return eval_optional;
 }
@@ -538,11 +597,11 @@ inline std::optional<bool> SimpleChessEngine::Searcher::SearchImplementation<
   SetBestMove(move);
   best_eval = eval;
 
-  auto &[max_depth, remaining_depth, alpha, beta] = status_;
+  auto &[max_depth, remaining_depth, ply, alpha, beta] = status_;
 
   if (best_eval > alpha) {
     if (best_eval >= beta) {
-      if (IsQuiet(best_move)) {
+      if (searcher_.current_position_.IsQuiet(best_move)) {
         UpdateQuietMove(best_move);
       }
       return true;
@@ -555,57 +614,55 @@ inline std::optional<bool> SimpleChessEngine::Searcher::SearchImplementation<
 }
 template <bool is_principal_variation, class ExitCondition>
   requires StopSearchCondition<ExitCondition>
-inline Searcher::SearchImplementation<is_principal_variation,
-                                      ExitCondition>::QuietRange
-SimpleChessEngine::Searcher::SearchImplementation<
+inline SearchResult SimpleChessEngine::Searcher::SearchImplementation<
     is_principal_variation,
-    ExitCondition>::OrderMoves(const MoveGenerator::Moves::iterator first,
-                               const MoveGenerator::Moves::iterator last) {
-  auto const &current_position = searcher_.current_position_;
+    ExitCondition>::PVSearch(MovePicker &move_picker) {
+  auto &current_position = searcher_.current_position_;
 
-  auto begin_of_ordering = first;
+  // the first move is searched by CheckFirstMove
+  std::size_t move_index = 1;
+  for (; const auto next_move = move_picker.SelectNextMove(); ++move_index) {
+    const auto &move = *next_move;
 
-  if (has_stored_move) {
-    std::iter_swap(std::find(first, last, best_move), begin_of_ordering++);
-  }
+    const bool is_quiet = current_position.IsQuiet(move);
+    const bool gives_check = current_position.GivesCheck(move);
 
-  auto [quiet_begin, quiet_end] = searcher_.OrderMoves(
-      begin_of_ordering, last, status_.max_depth - status_.remaining_depth,
-      current_position.GetSideToMove());
-  return QuietRange{quiet_begin, quiet_end};
-}
-template <bool is_principal_variation, class ExitCondition>
-  requires StopSearchCondition<ExitCondition>
-inline SearchResult SimpleChessEngine::Searcher::SearchImplementation<
-    is_principal_variation,
-    ExitCondition>::PVSearch(const MoveGenerator::Moves::iterator first,
-                             const MoveGenerator::Moves::iterator last,
-                             const QuietRange &ordeing_result) {
-  auto &current_position = searcher_.current_position_;
+    if (CanPruneMove(move, move_index, gives_check)) {
+      continue;
+    }
 
-  bool is_quiet = false;
-  for (auto it = first; it != last; ++it) {
-    const auto &move = *it;
+    const auto reduction =
+        GetReduction(move_picker, move, move_index, gives_check);
 
-    if (it >= ordeing_result.quiet_begin) is_quiet = true;
-    if (it >= ordeing_result.quiet_end) is_quiet = false;
+    PrefetchChild(move);
 
     current_position.DoMove(move);  // make the move and search the tree
 
-    auto &[max_depth, remaining_depth, alpha, beta] = status_;
+    auto &[max_depth, remaining_depth, ply, alpha, beta] = status_;
 
-    auto temp_eval_optional =
-        Search<false>({max_depth, static_cast<Depth>(remaining_depth - 1),
-                       -alpha - 1, -alpha});  // ZWS
+    auto temp_eval_optional = Search<false>(
+        {max_depth, static_cast<Depth>(remaining_depth - 1 - reduction),
+         static_cast<Depth>(ply + 1), -alpha - 1, -alpha});  // ZWS
 
     if (!temp_eval_optional) return std::nullopt;
 
     auto temp_eval = -*temp_eval_optional;
 
+    if (reduction > 0 && temp_eval > alpha) /* the reduction failed */
+    {
+      temp_eval_optional =
+          Search<false>({max_depth, static_cast<Depth>(remaining_depth - 1),
+                         static_cast<Depth>(ply + 1), -alpha - 1, -alpha});
+      if (!temp_eval_optional) return std::nullopt;
+
+      temp_eval = -*temp_eval_optional;
+    }
+
     if (temp_eval > alpha) /* make a research (ZWS failed) */
     {
-      temp_eval_optional = Search<false>(
-          {max_depth, static_cast<Depth>(remaining_depth - 1), -beta, -alpha});
+      temp_eval_optional =
+          Search<false>({max_depth, static_cast<Depth>(remaining_depth - 1),
+                         static_cast<Depth>(ply + 1), -beta, -alpha});
       if (!temp_eval_optional) return std::nullopt;
 
       temp_eval = -*temp_eval_optional;
@@ -617,7 +674,7 @@ inline SearchResult SimpleChessEngine::Searcher::SearchImplementation<
     }
 
     // undo the move
-    current_position.UndoMove(move, irreversible_data);
+    current_position.UndoMove(move);
 
     if (temp_eval > best_eval) {
       SetBestMove(move);
@@ -645,11 +702,39 @@ template <bool is_principal_variation, class ExitCondition>
   requires StopSearchCondition<ExitCondition>
 inline void SimpleChessEngine::Searcher::SearchImplementation<
     is_principal_variation, ExitCondition>::UpdateQuietMove(const Move &move) {
-  const auto [from, to, captured_piece] = GetMoveData(move);
-  searcher_.history_[side_to_move_idx][from][to] +=
+  searcher_.history_[side_to_move_idx][move.GetFrom()][move.GetTo()] +=
       status_.remaining_depth * status_.remaining_depth;
-  searcher_.killers_.TryAdd(status_.max_depth - status_.remaining_depth, move);
+  searcher_.killers_.TryAdd(status_.ply, move);
+}
+template <bool is_principal_variation, class ExitCondition>
+  requires StopSearchCondition<ExitCondition>
+inline Depth
+Searcher::SearchImplementation<is_principal_variation, ExitCondition>::
+    GetReduction(const MovePicker &move_picker, const Move &move,
+                 const std::size_t move_index, const bool gives_check) const {
+  const auto remaining_depth = status_.remaining_depth;
+  if (!PruneParameters::lmr::enabled || is_under_check ||
+      remaining_depth < PruneParameters::lmr::min_depth ||
+      move_index < PruneParameters::lmr::min_move_index) {
+    return 0;
+  }
+
+  int reduction = kReductions[remaining_depth][move_index];
+
+  // the principal variation is reduced less
+  reduction -= is_principal_variation;
+  // so are moves that are likely to be good or to change the position a lot
+  reduction -= gives_check;
+  reduction -= !searcher_.current_position_.IsQuiet(move);
+  reduction -= move_picker.IsKiller(move);
+  // a move that caused a cutoff at this depth before has a good history
+  reduction -= searcher_.history_[side_to_move_idx][move.GetFrom()]
+                                 [move.GetTo()] >=
+               static_cast<uint64_t>(remaining_depth * remaining_depth);
+
+  return static_cast<Depth>(std::clamp(reduction, 0, remaining_depth - 2));
 }
+
 template <bool is_principal_variation, class ExitCondition>
   requires StopSearchCondition<ExitCondition>
 inline bool Searcher::SearchImplementation<is_principal_variation,
@@ -660,4 +745,111 @@ inline bool Searcher::SearchImplementation<is_principal_variation,
          static_eval > status_.beta + PruneParameters::rfp::threshold *
                                           status_.remaining_depth;
 }
+
+template <bool is_principal_variation, class ExitCondition>
+  requires StopSearchCondition<ExitCondition>
+inline bool
+Searcher::SearchImplementation<is_principal_variation, ExitCondition>::
+    CanPruneMove(const Move &move, const std::size_t move_index,
+                 const bool gives_check) const {
+  const auto &position = searcher_.current_position_;
+  const auto &[max_depth, remaining_depth, ply, alpha, beta] = status_;
+
+  // keep at least one move that is not mated and every move of the root
+  if (ply == 0 || is_under_check || IsMateScore(best_eval)) {
+    return false;
+  }
+
+  const bool is_quiet = position.IsQuiet(move) &&
+                        move.GetType() != MoveType::kPromotion;
+
+  if (is_quiet && !gives_check) {
+    if (PruneParameters::fp::enabled &&
+        remaining_depth <= PruneParameters::fp::depth_limit &&
+        static_eval + PruneParameters::fp::base_margin +
+                PruneParameters::fp::depth_margin * remaining_depth <=
+            alpha) {
+      return true;
+    }
+
+    if (PruneParameters::lmp::enabled &&
+        remaining_depth <= PruneParameters::lmp::depth_limit &&
+        move_index >= PruneParameters::lmp::base_move_count +
+                          static_cast<std::size_t>(remaining_depth *
+                                                   remaining_depth)) {
+      return true;
+    }
+  }
+
+  if (PruneParameters::see::enabled &&
+      remaining_depth <= PruneParameters::see::depth_limit) {
+    // quiet moves may lose less material than captures to be pruned
+    const Eval threshold =
+        is_quiet ? -PruneParameters::see::quiet_margin * remaining_depth
+                 : -PruneParameters::see::capture_margin * remaining_depth *
+                       remaining_depth;
+    return !position.StaticExchangeEvaluation(move, threshold);
+  }
+
+  return false;
+}
+
+template <bool is_principal_variation, class ExitCondition>
+  requires StopSearchCondition<ExitCondition>
+inline bool Searcher::SearchImplementation<is_principal_variation,
+                                           ExitCondition>::CanNullMove() const {
+  if constexpr (is_principal_variation) return false;
+  const auto &position = searcher_.current_position_;
+  // without pieces a side is often in zugzwang, so passing is not safe
+  return !is_under_check &&
+         status_.remaining_depth >= PruneParameters::nmp::min_depth &&
+         static_eval >= status_.beta && !IsMateScore(status_.beta) &&
+         status_.ply >= searcher_.null_move_min_ply_ &&
+         position.GetPliesFromNull() > 0 &&
+         position.GetNonPawnMaterial(position.GetSideToMove()) > 0;
+}
+
+template <bool is_principal_variation, class ExitCondition>
+  requires StopSearchCondition<ExitCondition>
+inline SearchResult Searcher::SearchImplementation<
+    is_principal_variation, ExitCondition>::NullMoveSearch() {
+  auto &current_position = searcher_.current_position_;
+  const auto &[max_depth, remaining_depth, ply, alpha, beta] = status_;
+
+  const int reduction = PruneParameters::nmp::base_reduction +
+                        remaining_depth / PruneParameters::nmp::depth_divisor;
+  const auto null_depth =
+      static_cast<Depth>(std::max(0, remaining_depth - 1 - reduction));
+
+  current_position.DoNullMove();
+  const auto null_eval_optional = Search<false>(
+      {max_depth, null_depth, static_cast<Depth>(ply + 1), -beta, -beta + 1});
+  if (!null_eval_optional) return std::nullopt;
+  current_position.UndoNullMove();
+
+  auto null_eval = -*null_eval_optional;
+  if (null_eval < beta) {
+    return null_eval;
+  }
+
+  // a mate found after passing the turn is not proven
+  if (IsMateScore(null_eval)) {
+    null_eval = beta;
+  }
+
+  // a verification is not nested into another one
+  if (remaining_depth < PruneParameters::nmp::verification_depth ||
+      searcher_.null_move_min_ply_ != 0) {
+    return null_eval;
+  }
+
+  // zugzwang is verified by the same search of the node without null moves
+  searcher_.null_move_min_ply_ = static_cast<Depth>(ply + 3 * null_depth / 4);
+  const auto verification_optional =
+      Search<false>({max_depth, null_depth, ply, beta - 1, beta});
+  searcher_.null_move_min_ply_ = 0;
+  if (!verification_optional) return std::nullopt;
+
+  return *verification_optional >= beta ? null_eval : *verification_optional;
+}
 }  // namespace SimpleChessEngine
@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "BitBoard.h"
+#include "Utility.h"
+
+namespace SimpleChessEngine {
+/**
+ * \brief Attacks of a whole set of pieces, computed without looping over them.
+ *
+ * \details Sliding attacks use Kogge-Stone occluded fills: every direction is
+ * filled in three shift steps, whatever the number of pieces is. With AVX2
+ * four directions are filled at once, one in each 64-bit lane.
+ */
+namespace Setwise {
+constexpr uint64_t kNotFileA = ~static_cast<uint64_t>(kFileBB.front());
+constexpr uint64_t kNotFileH = ~static_cast<uint64_t>(kFileBB.back());
+
+/**
+ * \brief Gets all squares attacked by the knights.
+ */
+[[nodiscard]] constexpr Bitboard GetKnightAttacks(const Bitboard knights) {
+  const auto bb = static_cast<uint64_t>(knights);
+  const auto east = (bb << 1) & kNotFileA;
+  const auto west = (bb >> 1) & kNotFileH;
+  const auto east2 = (bb << 2) & kNotFileA & (kNotFileA << 1);
+  const auto west2 = (bb >> 2) & kNotFileH & (kNotFileH >> 1);
+  const auto one = east | west;
+  const auto two = east2 | west2;
+  return Bitboard{one << 16 | one >> 16 | two << 8 | two >> 8};
+}
+
+/**
+ * \brief Gets all squares attacked by the sliding pieces.
+ *
+ * \param straight Pieces that attack along files and ranks.
+ * \param diagonal Pieces that attack along diagonals.
+ * \param empty Squares that do not block the attacks.
+ *
+ * \return Attacked squares.
+ */
+[[nodiscard]] inline Bitboard GetSlidingAttacks(const Bitboard straight,
+                                                const Bitboard diagonal,
+                                                const Bitboard empty) {
+  const auto rooks = static_cast<uint64_t>(straight);
+  const auto bishops = static_cast<uint64_t>(diagonal);
+  const auto free = static_cast<uint64_t>(empty);
+
+#ifdef __AVX2__
+  // lanes are north, east, north-east and north-west for left shifts,
+  // south, west, south-west and south-east for right shifts
+  const auto shift = _mm256_setr_epi64x(8, 1, 9, 7);
+  const auto double_shift = _mm256_add_epi64(shift, shift);
+  const auto quad_shift = _mm256_add_epi64(double_shift, double_shift);
+
+  const auto fill = [&](const __m256i sliders, __m256i pro, const __m256i mask,
+                        const auto shift_bits) {
+    auto gen = sliders;
+    pro = _mm256_and_si256(pro, mask);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift_bits(gen, shift)));
+    pro = _mm256_and_si256(pro, shift_bits(pro, shift));
+    gen = _mm256_or_si256(gen,
+                          _mm256_and_si256(pro, shift_bits(gen, double_shift)));
+    pro = _mm256_and_si256(pro, shift_bits(pro, double_shift));
+    gen = _mm256_or_si256(gen,
+                          _mm256_and_si256(pro, shift_bits(gen, quad_shift)));
+    return _mm256_and_si256(shift_bits(gen, shift), mask);
+  };
+  const auto shift_left = [](const __m256i bits, const __m256i count) {
+    return _mm256_sllv_epi64(bits, count);
+  };
+  const auto shift_right = [](const __m256i bits, const __m256i count) {
+    return _mm256_srlv_epi64(bits, count);
+  };
+
+  const auto sliders = _mm256_setr_epi64x(static_cast<int64_t>(rooks),
+                                          static_cast<int64_t>(rooks),
+                                          static_cast<int64_t>(bishops),
+                                          static_cast<int64_t>(bishops));
+  const auto pro = _mm256_set1_epi64x(static_cast<int64_t>(free));
+
+  const auto left = fill(
+      sliders, pro,
+      _mm256_setr_epi64x(-1, static_cast<int64_t>(kNotFileA),
+                         static_cast<int64_t>(kNotFileA),
+                         static_cast<int64_t>(kNotFileH)),
+      shift_left);
+  const auto right = fill(
+      sliders, pro,
+      _mm256_setr_epi64x(-1, static_cast<int64_t>(kNotFileH),
+                         static_cast<int64_t>(kNotFileH),
+                         static_cast<int64_t>(kNotFileA)),
+      shift_right);
+
+  alignas(32) std::array<uint64_t, 4> lanes{};
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()),
+                     _mm256_or_si256(left, right));
+  return Bitboard{lanes[0] | lanes[1] | lanes[2] | lanes[3]};
+#else
+  const auto fill = [free](uint64_t gen, const int shift,
+                           const uint64_t mask) {
+    const auto shift_bits = [shift](const uint64_t bits, const int times) {
+      return shift > 0 ? bits << shift * times : bits >> -shift * times;
+    };
+    auto pro = free & mask;
+    gen |= pro & shift_bits(gen, 1);
+    pro &= shift_bits(pro, 1);
+    gen |= pro & shift_bits(gen, 2);
+    pro &= shift_bits(pro, 2);
+    gen |= pro & shift_bits(gen, 4);
+    return shift_bits(gen, 1) & mask;
+  };
+
+  return Bitboard{fill(rooks, 8, ~0ull) | fill(rooks, -8, ~0ull) |
+                  fill(rooks, 1, kNotFileA) | fill(rooks, -1, kNotFileH) |
+                  fill(bishops, 9, kNotFileA) | fill(bishops, 7, kNotFileH) |
+                  fill(bishops, -9, kNotFileH) | fill(bishops, -7, kNotFileA)};
+#endif
+}
+}  // namespace Setwise
+}  // namespace SimpleChessEngine
@@ -1,7 +1,9 @@
 #pragma once
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <numeric>
+#include <thread>
 #include <variant>
 
 #include "Evaluation.h"
@@ -39,6 +41,11 @@ struct TranspositionTableInfo {
   std::size_t tt_hits{};
 };
 
+struct HashAllocationInfo {
+  std::size_t size_in_mb{};
+  PageKind page_kind{};
+};
+
 struct EBFInfo {
   float last_ebf;
   float avg_odd_even_ebf;
@@ -55,6 +62,8 @@ std::ostream& operator<<(std::ostream& out,
                          const PrincipalVariationInfo& principal_variation);
 std::ostream& operator<<(std::ostream& out,
                          const TranspositionTableInfo& tt_info);
+std::ostream& operator<<(std::ostream& out,
+                         const HashAllocationInfo& hash_info);
 std::ostream& operator<<(std::ostream& out, const BestMoveInfo& bm_info);
 std::ostream& operator<<(std::ostream& out, const EBFInfo& ebf_info);
 
@@ -130,16 +139,34 @@ struct Pondering {
 };
 static_assert(SearchCondition<Pondering>);
 
+/**
+ * \brief Condition for helper threads of Lazy SMP.
+ *
+ * \details Helpers never read the condition of the main thread, the UCI thread
+ * may change it during the search. The main thread alone decides when to stop
+ * and then raises the flag.
+ */
+struct HelperCondition {
+  bool IsTimeToExit() const { return stop.load(std::memory_order_relaxed); }
+
+  const std::atomic_bool& stop;
+};
+static_assert(StopSearchCondition<HelperCondition>);
+
 /**
  * \brief Class that represents a chess engine.
  *
+ * \details Supports Lazy SMP: helper searchers run iterative deepening over
+ * their own copies of the position, sharing only the transposition table
+ * with the main searcher. The main searcher is the only one that reports.
+ *
  * \author nook0110
  */
 class ChessEngine {
  public:
   explicit ChessEngine(Position position = PositionFactory{}(),
                        std::ostream& o_stream = std::cout)
-      : o_stream_(o_stream) {
+      : o_stream_(o_stream), searcher_(transposition_table_) {
     SetPosition(std::move(position));
   }
 
@@ -158,6 +185,29 @@ class ChessEngine {
 
   void ComputeBestMove(SearchCondition auto& conditions);
 
+  /**
+   * \brief Sets the number of threads used by search.
+   *
+   * \param threads Number of threads including the main one.
+   */
+  void SetThreads(std::size_t threads);
+
+  /**
+   * \brief Reallocates the transposition table.
+   *
+   * \param size_in_mb Size of the table in megabytes.
+   */
+  void SetHashSize(std::size_t size_in_mb) {
+    transposition_table_.Resize(size_in_mb);
+    PrintInfo(HashAllocationInfo{transposition_table_.GetSizeInMB(),
+                                 transposition_table_.GetPageKind()});
+  }
+
+  /**
+   * \brief Forgets everything learned from previous searches.
+   */
+  void Clear() { transposition_table_.Clear(); }
+
   [[nodiscard]] const Move& GetCurrentBestMove() const;
 
   void PrintBestMove() { o_stream_ << BestMoveInfo{GetCurrentBestMove()}; }
@@ -207,14 +257,42 @@ class ChessEngine {
   template <class Info>
   void PrintInfo(const Info& info);
 
-  std::optional<Eval> MakeIteration(Depth depth,
-                                    const StopSearchCondition auto& end);
+  static constexpr Depth kAspirationMinDepth = 4;
+  static constexpr Eval kAspirationDelta = 50;
+  static constexpr Eval kMaxAspirationDelta = 500;
+
+  /**
+   * \brief Searches the root to the depth.
+   *
+   * \details The window is centred on the score of the previous iteration
+   * and widened on the failed side until the score falls into it.
+   *
+   * \param searcher Searcher to use.
+   * \param depth Depth of the iteration.
+   * \param previous_eval Score of the previous iteration, if there was one.
+   * \param end Condition to stop the search.
+   *
+   * \return Score of the root or nullopt if the search was stopped.
+   */
+  static std::optional<Eval> MakeIteration(
+      Searcher& searcher, Depth depth, std::optional<Eval> previous_eval,
+      const StopSearchCondition auto& end);
+
+  void StartHelpers();
+
+  void StopHelpers();
 
   std::ostream& o_stream_;
 
+  TranspositionTable transposition_table_;
+
   Searcher searcher_;
   Position position_;
 
+  std::vector<Searcher> helpers_;
+  std::vector<std::thread> helper_threads_;
+  std::atomic_bool stop_helpers_ = false;
+
   Move best_move_;
   std::optional<Move> ponder_move_;
 };
@@ -224,18 +302,23 @@ namespace SimpleChessEngine {
 inline void SimpleChessEngine::ChessEngine::ComputeBestMove(
     SearchCondition auto& condition) {
   const TimePoint start_time = std::chrono::system_clock::now();
+  transposition_table_.NewSearch();
   searcher_.InitStartOfSearch();
+  StartHelpers();
 
   Searcher::DebugInfo info;
+  std::optional<Eval> previous_eval;
 
   for (Depth current_depth = 1;
        condition.ShouldContinueIteration() && current_depth < kMaxSearchPly;
        ++current_depth) {
     PrintInfo(DepthInfo{current_depth});
-    const auto eval_optional = MakeIteration(current_depth, condition);
+    const auto eval_optional =
+        MakeIteration(searcher_, current_depth, previous_eval, condition);
     if (!eval_optional) {
       break;
     }
+    previous_eval = eval_optional;
     condition.Update(IterationInfo{searcher_, *eval_optional, current_depth});
 
     info += searcher_.GetInfo();
@@ -250,20 +333,108 @@ inline void SimpleChessEngine::ChessEngine::ComputeBestMove(
     best_move_ = searcher_.GetCurrentBestMove();
   }
 
+  StopHelpers();
+
   PrintBestMove(BestMoveInfo{best_move_, ponder_move_});
 }
 
+inline void ChessEngine::SetThreads(const std::size_t threads) {
+  assert(threads > 0);
+  helpers_.clear();
+  helpers_.reserve(threads - 1);
+  for (std::size_t helper = 1; helper < threads; ++helper) {
+    helpers_.emplace_back(transposition_table_);
+  }
+}
+
+inline void ChessEngine::StartHelpers() {
+  // depth staggering: helper skips blocks of kSkipSize depths, shifted by
+  // kSkipPhase, so that helpers spread over different iterations
+  static constexpr std::array<Depth, 20> kSkipSize = {
+      1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+  static constexpr std::array<Depth, 20> kSkipPhase = {
+      0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+  stop_helpers_ = false;
+  for (std::size_t idx = 0; idx < helpers_.size(); ++idx) {
+    auto& helper = helpers_[idx];
+    helper.SetPosition(position_);
+    helper.InitStartOfSearch();
+
+    helper_threads_.emplace_back([this, &helper,
+                                  skip_size = kSkipSize[idx % kSkipSize.size()],
+                                  skip_phase =
+                                      kSkipPhase[idx % kSkipPhase.size()]] {
+      const HelperCondition helper_condition{stop_helpers_};
+      std::optional<Eval> previous_eval;
+      for (Depth current_depth = 1; !helper_condition.IsTimeToExit() &&
+                                    current_depth < kMaxSearchPly;
+           ++current_depth) {
+        if ((current_depth + skip_phase) / skip_size % 2) {
+          continue;
+        }
+        previous_eval = MakeIteration(helper, current_depth, previous_eval,
+                                      helper_condition);
+        if (!previous_eval) {
+          break;
+        }
+      }
+    });
+  }
+}
+
+inline void ChessEngine::StopHelpers() {
+  stop_helpers_ = true;
+  for (auto& thread : helper_threads_) {
+    thread.join();
+  }
+  helper_threads_.clear();
+}
+
 inline const Move& ChessEngine::GetCurrentBestMove() const {
   return searcher_.GetCurrentBestMove();
 }
 
 inline std::optional<Eval> ChessEngine::MakeIteration(
-    const Depth current_depth, const StopSearchCondition auto& condition) {
+    Searcher& searcher, const Depth current_depth,
+    const std::optional<Eval> previous_eval,
+    const StopSearchCondition auto& condition) {
   constexpr auto neg_inf = std::numeric_limits<Eval>::min() / 2;
   constexpr auto pos_inf = std::numeric_limits<Eval>::max() / 2;
 
-  return searcher_.Search<true>(condition, current_depth, current_depth,
-                                neg_inf, pos_inf);
+  searcher.ClearInfo();
+
+  // a mate score is exact, it does not predict the next score within a delta
+  if (!previous_eval || IsMateScore(*previous_eval) ||
+      current_depth < kAspirationMinDepth) {
+    return searcher.Search<true>(condition, current_depth, current_depth,
+                                 neg_inf, pos_inf);
+  }
+
+  Eval delta = kAspirationDelta;
+  Eval alpha = *previous_eval - delta;
+  Eval beta = *previous_eval + delta;
+
+  for (;;) {
+    const auto eval_optional = searcher.Search<true>(
+        condition, current_depth, current_depth, alpha, beta);
+    if (!eval_optional) {
+      return std::nullopt;
+    }
+    const auto eval = *eval_optional;
+
+    delta *= 2;
+    // the window is opened on the failed side if it grows too wide or the
+    // score turns out to be a mate
+    const bool is_open = delta > kMaxAspirationDelta || IsMateScore(eval);
+    if (eval <= alpha) {
+      alpha = is_open ? neg_inf : eval - delta;
+    } else if (eval >= beta) {
+      beta = is_open ? pos_inf : eval + delta;
+    } else {
+      return eval;
+    }
+  }
 }
 
 template <class Info>
@@ -312,6 +483,13 @@ inline std::ostream& operator<<(std::ostream& out,
   return out << "info tt_hits " << tt_info.tt_hits << std::endl;
 }
 
+inline std::ostream& operator<<(std::ostream& out,
+                                const HashAllocationInfo& hash_info) {
+  return out << "info string hash " << hash_info.size_in_mb << " MB in "
+             << (hash_info.page_kind == PageKind::kHuge ? "huge" : "default")
+             << " pages" << std::endl;
+}
+
 inline std::ostream& operator<<(std::ostream& out,
                                 const BestMoveInfo& bm_info) {
   out << "bestmove " << bm_info.move;
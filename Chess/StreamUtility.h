@@ -46,81 +46,32 @@ inline std::ostream& PrintCoordinates(const Coordinates coordinates,
   return stream;
 }
 
-inline std::ostream& operator<<(std::ostream& stream, const DefaultMove& move)
-{
-  const auto from = GetCoordinates(move.from);
-  const auto to = GetCoordinates(move.to);
-
-  PrintCoordinates(from, stream);
-  PrintCoordinates(to, stream);
-
-  return stream;
-}
-inline std::ostream& operator<<(std::ostream& stream, const PawnPush& move)
-{
-  const auto from = GetCoordinates(move.from);
-  const auto to = GetCoordinates(move.to);
-
-  PrintCoordinates(from, stream);
-  PrintCoordinates(to, stream);
-
-  return stream;
-}
-inline std::ostream& operator<<(std::ostream& stream, const DoublePush& move)
-{
-  const auto from = GetCoordinates(move.from);
-  const auto to = GetCoordinates(move.to);
-
-  PrintCoordinates(from, stream);
-  PrintCoordinates(to, stream);
-
-  return stream;
-}
-inline std::ostream& operator<<(std::ostream& stream, const EnCroissant& move)
-{
-  const auto from = GetCoordinates(move.from);
-  const auto to = GetCoordinates(move.to);
-
-  PrintCoordinates(from, stream);
-  PrintCoordinates(to, stream);
-
-  return stream;
-}
-inline std::ostream& operator<<(std::ostream& stream, const Promotion& move)
+inline std::ostream& operator<<(std::ostream& stream, const Move& move)
 {
-  const auto from = GetCoordinates(move.from);
-  const auto to = GetCoordinates(move.to);
-
-  PrintCoordinates(from, stream);
-  PrintCoordinates(to, stream);
-
-  constexpr std::array pieces_name = {' ', 'p', 'n', 'b', 'r', 'q', 'k'};
-
-  std::cout << pieces_name[static_cast<size_t>(move.promoted_to)];
+  const auto from = move.GetFrom();
+  auto to = move.GetTo();
 
-  return stream;
-}
-
-inline std::ostream& operator<<(std::ostream& stream, const Castling& move)
-{
-  const auto from = GetCoordinates(move.king_from);
+  if (move.GetType() == MoveType::kCastling)
+  {
+    static constexpr std::array kCastlingShifts = {Compass::kEast,
+                                                   Compass::kWest};
 
-  static constexpr std::array kCastlingShifts = {Compass::kEast,
-                                                 Compass::kWest};
+    const auto shift =
+        kCastlingShifts[static_cast<size_t>(move.GetCastlingSide())];
 
-  const auto shift = kCastlingShifts[static_cast<size_t>(move.side)];
+    to = Shift(Shift(from, shift), shift);
+  }
 
-  const auto to = GetCoordinates(Shift(Shift(move.king_from, shift), shift));
+  PrintCoordinates(GetCoordinates(from), stream);
+  PrintCoordinates(GetCoordinates(to), stream);
 
-  PrintCoordinates(from, stream);
-  PrintCoordinates(to, stream);
+  if (move.GetType() == MoveType::kPromotion)
+  {
+    constexpr std::array pieces_name = {' ', 'p', 'n', 'b', 'r', 'q', 'k'};
 
-  return stream;
-}
+    stream << pieces_name[static_cast<size_t>(move.GetPromotedTo())];
+  }
 
-inline std::ostream& operator<<(std::ostream& stream, const Move& move)
-{
-  std::visit([&](const auto& move) { stream << move; }, move);
   return stream;
 }
 }  // namespace SimpleChessEngine
\ No newline at end of file
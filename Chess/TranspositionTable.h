@@ -1,7 +1,17 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <new>
+#include <optional>
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
 
 #include "Hasher.h"
+#include "LargePages.h"
 #include "Move.h"
 #include "Position.h"
 namespace SimpleChessEngine {
@@ -11,49 +21,258 @@ inline uint8_t operator&(const Bound lhs, const Bound rhs) {
   return static_cast<uint8_t>(lhs) & static_cast<uint8_t>(rhs);
 }
 
-template <size_t TableSize>
+/**
+ * \brief Heap-allocated transposition table with runtime size.
+ *
+ * \details Entries are grouped in clusters, each one fits a cache line, so
+ * a probe costs at most one cache miss. Number of clusters is always a power
+ * of two, so the index of a cluster is just the lowest bits of the hash and
+ * an entry keeps only the highest bits of it.
+ *
+ * The table is shared by search threads without any locks. Data of an entry
+ * is a single atomic word and its key is stored xor-ed with that word, so an
+ * entry written by two threads at once fails the key check instead of being
+ * read torn.
+ */
 class TranspositionTable {
-  static_assert(!(TableSize & (TableSize - 1)));
-
  public:
-#pragma pack(push, 1)
+  static constexpr std::size_t kDefaultSizeInMB = 16;
+  static constexpr std::size_t kMaxSizeInMB = 1 << 15;
+  static constexpr std::size_t kCacheLineSize = 64;
+
+  /**
+   * \brief Compact data of an entry as it is stored in the table.
+   */
   struct Node {
-    Hash true_hash{};
-    Move move{};
-    Eval score{};
-    Depth depth : 6 {};
-    Bound bound : 2 {};
-    Age age{};
+    uint16_t move{};        //!< Packed best move.
+    int16_t score{};        //!< Score of the search.
+    int16_t static_eval{};  //!< Static evaluation of the position.
+    Depth depth{};          //!< Remaining depth of the search.
+    uint8_t age_bound{};    //!< Age of the search and bound of the score.
+  };
+  static_assert(sizeof(Node) == sizeof(uint64_t));
+
+  /**
+   * \brief Unpacked entry of a position.
+   */
+  struct Entry {
+    Move move;
+    Eval score;
+    Eval static_eval;
+    Depth depth;
+    Bound bound;
+  };
+
+  static constexpr std::size_t kClusterSize =
+      kCacheLineSize / (sizeof(uint64_t) + sizeof(uint16_t));
+
+  struct alignas(kCacheLineSize) Cluster {
+    std::array<std::atomic<uint64_t>, kClusterSize> data{};
+    std::array<std::atomic<uint16_t>, kClusterSize> keys{};
   };
-#pragma pack(pop)
+  static_assert(sizeof(Cluster) == kCacheLineSize);
+
+  explicit TranspositionTable(const std::size_t size_in_mb = kDefaultSizeInMB) {
+    Resize(size_in_mb);
+  }
+
+  /**
+   * \brief Reallocates the table. All entries are lost.
+   *
+   * \details The new table is allocated before the old one is freed. If there
+   * is not enough memory, the size is halved until an allocation succeeds.
+   * If none does, the old table is kept. GetSizeInMB tells the size in use.
+   *
+   * \param size_in_mb Upper bound of the table size in megabytes.
+   */
+  void Resize(const std::size_t size_in_mb) {
+    auto clusters = std::bit_floor(std::max<std::size_t>(
+        1, std::min(size_in_mb, kMaxSizeInMB) * 1024 * 1024 / sizeof(Cluster)));
+    for (;; clusters /= 2) {
+      try {
+        table_ = LargePageArray<Cluster>(clusters);
+        return;
+      } catch (const std::bad_alloc&) {
+        if (clusters == 1) {
+          // a table with no clusters can not be indexed
+          if (table_.size() == 0) {
+            throw;
+          }
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief Gets the kind of pages the table is placed in.
+   */
+  [[nodiscard]] PageKind GetPageKind() const { return table_.GetPageKind(); }
+
+  /**
+   * \brief Gets the size of the table in megabytes.
+   */
+  [[nodiscard]] std::size_t GetSizeInMB() const {
+    return table_.size() * sizeof(Cluster) / (1024 * 1024);
+  }
+
+  /**
+   * \brief Clears all entries of the table.
+   */
+  void Clear() {
+    for (auto& cluster : table_) {
+      for (std::size_t i = 0; i < kClusterSize; ++i) {
+        cluster.data[i].store(0, std::memory_order_relaxed);
+        cluster.keys[i].store(0, std::memory_order_relaxed);
+      }
+    }
+    age_ = 0;
+  }
+
+  /**
+   * \brief Starts a new root search, older entries become replaceable.
+   */
+  void NewSearch() { ++age_; }
+
+  /**
+   * \brief Finds an entry of the position.
+   *
+   * \param position The position.
+   *
+   * \return Entry of the position or nullopt if there is no such entry or
+   * its move is not pseudo-legal in the position. The move of the entry is
+   * empty if no move was found to be the best.
+   */
+  [[nodiscard]] std::optional<Entry> Probe(const Position& position) const {
+    const auto hash = position.GetHash();
+    const auto& cluster = GetCluster(hash);
+    for (std::size_t i = 0; i < kClusterSize; ++i) {
+      const auto data = cluster.data[i].load(std::memory_order_relaxed);
+      const auto key = cluster.keys[i].load(std::memory_order_relaxed);
+      const auto node = std::bit_cast<Node>(data);
+      if ((key ^ Fold(data)) != GetKey(hash) || IsEmpty(node)) {
+        continue;
+      }
+      // a move that can not be played here means that keys have collided,
+      // the entry of the position may still be in a later slot; quiescence
+      // entries may have no move at all
+      const auto move = Move::FromRaw(node.move);
+      if (move != Move{} && !position.IsPseudoLegal(move)) {
+        continue;
+      }
+      return Entry{move, node.score, node.static_eval, node.depth,
+                   GetBound(node)};
+    }
+    return std::nullopt;
+  }
 
-  [[nodiscard]] bool Contains(const Position& position) const {
-    return position.GetHash() == GetNode(position).true_hash;
+  /**
+   * \brief Starts loading the cluster of the hash into the cache.
+   *
+   * \param hash Hash of a position that is going to be probed soon.
+   */
+  void Prefetch(const Hash hash) const {
+#ifdef _MSC_VER
+    _mm_prefetch(reinterpret_cast<const char*>(&GetCluster(hash)), _MM_HINT_T0);
+#else
+    __builtin_prefetch(&GetCluster(hash));
+#endif
   }
 
   void SetEntry(const Position& position, const Move& move, const Eval score,
-                const Depth depth, const Bound bound, const Age age) {
-    Node inserting_node = {position.GetHash(), move, score, depth, bound, age};
-    auto& entry_node = GetNode(position);
-    if (bound == Bound::kExact ||
-        !(entry_node.bound == Bound::kExact && entry_node.age == age)) {
-      entry_node = inserting_node;
+                const Depth depth, const Bound bound, const Eval static_eval) {
+    const auto hash = position.GetHash();
+    auto& cluster = GetCluster(hash);
+
+    std::size_t replace = 0;
+    int replace_worth = std::numeric_limits<int>::max();
+    for (std::size_t i = 0; i < kClusterSize; ++i) {
+      const auto data = cluster.data[i].load(std::memory_order_relaxed);
+      const auto key = cluster.keys[i].load(std::memory_order_relaxed);
+      const auto node = std::bit_cast<Node>(data);
+      if ((key ^ Fold(data)) == GetKey(hash) && !IsEmpty(node)) {
+        // keep deeper results of the current search unless they are inexact
+        if (bound != Bound::kExact && GetRelativeAge(node) == 0 &&
+            node.depth > depth + kSameHashDepthMargin) {
+          return;
+        }
+        replace = i;
+        break;
+      }
+      if (const auto worth = GetWorth(node); worth < replace_worth) {
+        replace = i;
+        replace_worth = worth;
+      }
     }
+
+    const auto data = std::bit_cast<uint64_t>(
+        Node{move.GetRaw(), ClampScore(score), ClampScore(static_eval), depth,
+             static_cast<uint8_t>(age_ << kBoundBits |
+                                  static_cast<uint8_t>(bound))});
+    cluster.data[replace].store(data, std::memory_order_relaxed);
+    cluster.keys[replace].store(GetKey(hash) ^ Fold(data),
+                                std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr Depth kSameHashDepthMargin = 2;
+  static constexpr int kAgeWeight = 8;
+  static constexpr int kExactBonus = 2;
+
+  static constexpr uint8_t kBoundBits = 2;
+  static constexpr uint8_t kBoundMask = (1 << kBoundBits) - 1;
+  static constexpr uint8_t kAgeMask = 0xFF >> kBoundBits;
+
+  [[nodiscard]] static uint16_t GetKey(const Hash hash) {
+    return static_cast<uint16_t>(hash >> 48);
+  }
+
+  /**
+   * \brief Folds the data word into 16 bits to protect the key with it.
+   */
+  [[nodiscard]] static uint16_t Fold(const uint64_t data) {
+    return static_cast<uint16_t>(data ^ data >> 16 ^ data >> 32 ^ data >> 48);
   }
 
-  const Move& GetMove(const Position& position) const {
-    assert(Contains(position));
-    return GetNode(position).move;
+  [[nodiscard]] static bool IsEmpty(const Node& node) {
+    return !(node.age_bound & kBoundMask);
   }
 
-  Node& GetNode(const Position& position) {
-    return table_[position.GetHash() % TableSize];
+  [[nodiscard]] static Bound GetBound(const Node& node) {
+    return static_cast<Bound>(node.age_bound & kBoundMask);
   }
 
-  const Node& GetNode(const Position& position) const {
-    return table_[position.GetHash() % TableSize];
+  [[nodiscard]] static int16_t ClampScore(const Eval score) {
+    return static_cast<int16_t>(
+        std::clamp<Eval>(score, std::numeric_limits<int16_t>::min(),
+                         std::numeric_limits<int16_t>::max()));
   }
 
-  std::array<Node, TableSize> table_;  //!< The table.
+  [[nodiscard]] uint8_t GetRelativeAge(const Node& node) const {
+    return (age_ - (node.age_bound >> kBoundBits)) & kAgeMask;
+  }
+
+  /**
+   * \brief Estimates how useful an entry is for keeping it in the table.
+   */
+  [[nodiscard]] int GetWorth(const Node& node) const {
+    if (IsEmpty(node)) {
+      return std::numeric_limits<int>::min();
+    }
+    return node.depth - kAgeWeight * GetRelativeAge(node) +
+           (GetBound(node) == Bound::kExact) * kExactBonus;
+  }
+
+  [[nodiscard]] Cluster& GetCluster(const Hash hash) {
+    return table_[hash & (table_.size() - 1)];
+  }
+
+  [[nodiscard]] const Cluster& GetCluster(const Hash hash) const {
+    return table_[hash & (table_.size() - 1)];
+  }
+
+  Age age_{};  //!< Generation of the current root search.
+
+  LargePageArray<Cluster> table_;  //!< The table.
 };
 }  // namespace SimpleChessEngine
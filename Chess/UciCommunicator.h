@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <future>
 #include <iostream>
 #include <optional>
@@ -56,6 +57,21 @@ class SearchThread {
 
   void Stop();
 
+  void SetThreads(const std::size_t threads) {
+    StopThread();
+    engine_.SetThreads(threads);
+  }
+
+  void SetHashSize(const std::size_t size_in_mb) {
+    StopThread();
+    engine_.SetHashSize(size_in_mb);
+  }
+
+  void NewGame() {
+    StopThread();
+    engine_.Clear();
+  }
+
  private:
   Condition GetCondition(const Info& info) {
     if (const auto tournament =
@@ -128,10 +144,67 @@ struct BooleanOption : public OptionBase {
   bool value_ = false;
 };
 
+struct SpinOption : public OptionBase {
+  SpinOption(std::string name, const std::size_t default_value,
+             const std::size_t min_value, const std::size_t max_value,
+             std::function<void(std::size_t)> on_change)
+      : OptionBase(std::move(name)),
+        value_(default_value),
+        default_value_(default_value),
+        min_value_(min_value),
+        max_value_(max_value),
+        on_change_(std::move(on_change)) {}
+
+  bool SetValue(const std::string& value) override {
+    std::size_t parsed_value;
+    if (!(std::stringstream{value} >> parsed_value) ||
+        parsed_value < min_value_ || parsed_value > max_value_) {
+      return false;
+    }
+    value_ = parsed_value;
+    on_change_(value_);
+    return true;
+  }
+
+  std::string GetOptionDescription() const override {
+    return "type spin default " + std::to_string(default_value_) + " min " +
+           std::to_string(min_value_) + " max " + std::to_string(max_value_);
+  }
+
+ private:
+  std::size_t value_;
+  std::size_t default_value_;
+  std::size_t min_value_;
+  std::size_t max_value_;
+  std::function<void(std::size_t)> on_change_;
+};
+
 using PonderOption = BooleanOption;
+
+struct ThreadsOption : public SpinOption {
+  static constexpr std::size_t kMaxThreads = 256;
+
+  explicit ThreadsOption(SearchThread& search_thread)
+      : SpinOption("Threads", 1, 1, kMaxThreads,
+                   [&search_thread](const std::size_t threads) {
+                     search_thread.SetThreads(threads);
+                   }) {}
+};
+
+struct HashOption : public SpinOption {
+  explicit HashOption(SearchThread& search_thread)
+      : SpinOption("Hash", TranspositionTable::kDefaultSizeInMB, 1,
+                   TranspositionTable::kMaxSizeInMB,
+                   [&search_thread](const std::size_t size_in_mb) {
+                     search_thread.SetHashSize(size_in_mb);
+                   }) {}
+};
+
 struct EngineOptions {
-  EngineOptions() {
+  explicit EngineOptions(SearchThread& search_thread) {
     options.emplace_back(std::make_unique<PonderOption>("Ponder"));
+    options.emplace_back(std::make_unique<ThreadsOption>(search_thread));
+    options.emplace_back(std::make_unique<HashOption>(search_thread));
   }
   std::vector<std::unique_ptr<OptionBase>> options;
   bool ParseSetoption(std::stringstream command) {
@@ -152,6 +225,7 @@ struct EngineOptions {
         return option->SetValue(value);
       }
     }
+    return false;
   }
 
   void PrintOptionsNames(std::ostream& out) {
@@ -166,7 +240,10 @@ class UciChessEngine {
  public:
   explicit UciChessEngine(std::istream& i_stream = std::cin,
                           std::ostream& o_stream = std::cout)
-      : i_stream_(i_stream), o_stream_(o_stream), search_thread_(o_stream) {}
+      : i_stream_(i_stream),
+        o_stream_(o_stream),
+        search_thread_(o_stream),
+        options_(search_thread_) {}
 
   ~UciChessEngine();
 
@@ -174,14 +251,14 @@ class UciChessEngine {
 
  private:
   void StartSearch(bool ponder);
-  void StopSearch();
+  void StopSearch() noexcept;
 
   void ParseCommand(std::stringstream command);
 
   void ParseUci(std::stringstream command);
   void ParseSetOption(std::stringstream command);
   void ParseIsReady(std::stringstream command) const;
-  static void ParseUciNewGame(std::stringstream command);
+  void ParseUciNewGame(std::stringstream command);
   void ParseFen(const std::string& fen);
   void ParseStartPos();
   void ParseMoves(std::stringstream command);
@@ -292,7 +369,8 @@ inline void UciChessEngine::ParseIsReady(std::stringstream) const {
   Send("readyok");
 }
 
-inline void UciChessEngine::ParseUciNewGame(std::stringstream) { /**/
+inline void UciChessEngine::ParseUciNewGame(std::stringstream) {
+  search_thread_.NewGame();
 }
 
 inline void UciChessEngine::ParseFen(const std::string& fen) {
@@ -5,6 +5,7 @@ int main(int argc, char** argv) {
   SimpleChessEngine::InitBetween<SimpleChessEngine::Piece::kRook>();
   SimpleChessEngine::InitPawnAttacks();
   SimpleChessEngine::InitPSQT();
+  SimpleChessEngine::InitCuckoo();
   if (argc == 1) {
     SimpleChessEngine::UciChessEngine uci;
     uci.Start();
@@ -3,6 +3,7 @@
 
 // WARNING! pch.h must be first header!
 #include <sstream>
+#include <thread>
 
 #include "../Chess/Attacks.cpp"
 #include "../Chess/Attacks.h"
@@ -12,11 +13,13 @@
 #include "../Chess/MoveFactory.h"
 #include "../Chess/MoveGenerator.cpp"
 #include "../Chess/MoveGenerator.h"
+#include "../Chess/MovePicker.h"
 #include "../Chess/Perft.cpp"
 #include "../Chess/Position.cpp"
 #include "../Chess/PositionFactory.h"
 #include "../Chess/Quiescence.h"
 #include "../Chess/SimpleChessEngine.h"
+#include "../Chess/TranspositionTable.h"
 
 using namespace SimpleChessEngine;
 
@@ -247,9 +250,8 @@ TEST(DoMove, DoAndUndoEqualZero) {
   for (const auto moves =
            MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(pos);
        const auto& move : moves) {
-    const auto irreversible_data = pos.GetIrreversibleData();
     pos.DoMove(move);
-    pos.UndoMove(move, irreversible_data);
+    pos.UndoMove(move);
 
     ASSERT_EQ(pos, start_pos);
   }
@@ -276,6 +278,41 @@ Position DoMoves(Position pos, const std::vector<std::string>& moves) {
   return pos;
 }
 
+TEST(DoNullMove, UndoRestoresPosition) {
+  const auto start_pos = DoMoves(PositionFactory{}(), {"e2e4"});
+  auto pos = start_pos;
+
+  pos.DoNullMove();
+  EXPECT_EQ(pos.GetSideToMove(), Player::kWhite);
+  EXPECT_FALSE(pos.GetEnCroissantSquare().has_value());
+  EXPECT_NE(pos.GetHash(), start_pos.GetHash());
+  pos.UndoNullMove();
+
+  ASSERT_EQ(pos, start_pos);
+  ASSERT_EQ(pos.GetHash(), start_pos.GetHash());
+}
+
+TEST(StateStack, LongGameKeepsRepetitions) {
+  const auto start_pos = PositionFactory{}();
+
+  // knights go back and forth until the oldest states are dropped
+  const std::vector<std::string> shuffle = {"g1f3", "g8f6", "f3g1", "f6g8"};
+  auto pos = start_pos;
+  for (size_t ply = 0; ply < 2 * Position::StateStack::kCapacity;
+       ply += shuffle.size()) {
+    pos = DoMoves(pos, shuffle);
+  }
+
+  EXPECT_EQ(pos, start_pos);
+  EXPECT_EQ(pos.GetHash(), start_pos.GetHash());
+  EXPECT_TRUE(pos.DetectRepetition());
+
+  const auto move = MoveFactory{}(pos, "g1f3");
+  pos.DoMove(move);
+  pos.UndoMove(move);
+  EXPECT_EQ(pos, start_pos);
+}
+
 TEST(TwoSimiliarPositions, DifferentHash) {
   const auto start_pos = PositionFactory{}();
 
@@ -289,6 +326,30 @@ TEST(TwoSimiliarPositions, DifferentHash) {
 
   ASSERT_NE(first_position.GetHash(), second_position.GetHash());
 }
+
+TEST(UpcomingRepetition, FindsReversibleMove) {
+  const auto start_pos = PositionFactory{}();
+
+  // black can return the knight to the start position
+  const auto pos = DoMoves(start_pos, {"g1f3", "g8f6", "f3g1"});
+  EXPECT_TRUE(pos.HasUpcomingRepetition(4));
+  // the repeated position is the root of the search
+  EXPECT_FALSE(pos.HasUpcomingRepetition(3));
+
+  // a pawn move resets the window
+  const auto after_pawn = DoMoves(start_pos, {"g1f3", "e7e5", "f3g1"});
+  EXPECT_FALSE(after_pawn.HasUpcomingRepetition(4));
+
+  // the rook goes around the pawn and can not go back through it
+  const std::vector<std::string> rook_tour = {"e8d8", "a1b1", "d8d7", "b1b3",
+                                              "d7e7", "b3a3", "e7e8"};
+  const auto blocked =
+      DoMoves(PositionFactory{}("4k3/8/8/8/8/8/P7/R3K3 b - - 0 1"), rook_tour);
+  EXPECT_FALSE(blocked.HasUpcomingRepetition(8));
+  const auto free =
+      DoMoves(PositionFactory{}("4k3/8/8/8/8/8/7P/R3K3 b - - 0 1"), rook_tour);
+  EXPECT_TRUE(free.HasUpcomingRepetition(8));
+}
 }  // namespace PositionTest
 
 namespace MoveGeneratorTests {
@@ -322,10 +383,10 @@ struct GameInfo {
 
   if (depth == 1) {
     for (const auto& move : moves) {
-      if (std::get_if<EnCroissant>(&move)) {
+      if (move.GetType() == MoveType::kEnCroissant) {
         answer.en_croissants.value()++;
       }
-      if (std::get_if<Castling>(&move)) {
+      if (move.GetType() == MoveType::kCastling) {
         answer.castlings.value()++;
       }
     }
@@ -337,10 +398,9 @@ struct GameInfo {
   }
 
   for (const auto& move : moves) {
-    const auto irreversible_data = position.GetIrreversibleData();
     position.DoMove(move);
     answer += CountPossibleGames(position, depth - 1);
-    position.UndoMove(move, irreversible_data);
+    position.UndoMove(move);
   }
 
   return answer;
@@ -396,6 +456,179 @@ TEST_P(GenerateMovesTest, Perft) {
   }
 }
 
+[[nodiscard]] std::size_t CountWrongChecks(Position& position,
+                                           const Depth depth) {
+  if (depth == 0) return 0;
+
+  std::size_t wrong = 0;
+  for (const auto& move :
+       MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(position)) {
+    const auto gives_check = position.GivesCheck(move);
+    position.DoMove(move);
+    wrong += gives_check != position.IsUnderCheck();
+    wrong += CountWrongChecks(position, depth - 1);
+    position.UndoMove(move);
+  }
+  return wrong;
+}
+
+TEST_P(GenerateMovesTest, GivesCheck) {
+  auto position = GetPosition();
+
+  constexpr Depth kMaxCheckDepth = 3;
+  EXPECT_EQ(CountWrongChecks(
+                position, std::min<Depth>(GetMaxDepth() - 1, kMaxCheckDepth)),
+            0);
+}
+
+[[nodiscard]] std::size_t CountWrongEvasions(Position& position,
+                                             const Depth depth) {
+  if (depth == 0) return 0;
+
+  const auto moves =
+      MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(position);
+
+  std::size_t wrong = 0;
+  if (position.IsUnderCheck()) {
+    const auto evasions =
+        MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kEvasions>(
+            position);
+    std::vector<Move> expected(moves.begin(), moves.end());
+    std::vector<Move> generated(evasions.begin(), evasions.end());
+    const auto by_raw = [](const Move lhs, const Move rhs) {
+      return lhs.GetRaw() < rhs.GetRaw();
+    };
+    std::ranges::sort(expected, by_raw);
+    std::ranges::sort(generated, by_raw);
+    wrong += expected != generated;
+  }
+
+  for (const auto& move : moves) {
+    position.DoMove(move);
+    wrong += CountWrongEvasions(position, depth - 1);
+    position.UndoMove(move);
+  }
+  return wrong;
+}
+
+TEST_P(GenerateMovesTest, Evasions) {
+  auto position = GetPosition();
+
+  constexpr Depth kMaxEvasionDepth = 4;
+  EXPECT_EQ(CountWrongEvasions(position, std::min<Depth>(GetMaxDepth() - 1,
+                                                         kMaxEvasionDepth)),
+            0);
+}
+
+TEST_P(GenerateMovesTest, GetHashAfter) {
+  auto position = GetPosition();
+
+  for (const auto& move :
+       MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(position)) {
+    const auto hash_after = position.GetHashAfter(move);
+    position.DoMove(move);
+    ASSERT_EQ(hash_after, position.GetHash());
+    for (const auto& reply :
+         MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(
+             position)) {
+      const auto reply_hash_after = position.GetHashAfter(reply);
+      position.DoMove(reply);
+      ASSERT_EQ(reply_hash_after, position.GetHash());
+      position.UndoMove(reply);
+    }
+    position.UndoMove(move);
+  }
+}
+
+TEST_P(GenerateMovesTest, IsLegal) {
+  auto position = GetPosition();
+
+  for (const auto& move :
+       MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(position)) {
+    position.DoMove(move);
+
+    std::vector<bool> is_generated(1 << 16);
+    for (const auto& reply :
+         MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(
+             position)) {
+      is_generated[reply.GetRaw()] = true;
+    }
+    // every 16-bit value is checked, as if it came from a hash collision
+    for (uint32_t raw = 0; raw < (1 << 16); ++raw) {
+      const auto reply = Move::FromRaw(static_cast<uint16_t>(raw));
+      const auto is_legal =
+          position.IsPseudoLegal(reply) && position.IsLegal(reply);
+      ASSERT_EQ(is_legal, is_generated[raw]) << raw;
+    }
+
+    position.UndoMove(move);
+  }
+}
+
+TEST_P(GenerateMovesTest, AttackedBy) {
+  auto position = GetPosition();
+
+  for (const auto& move :
+       MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(position)) {
+    position.DoMove(move);
+    for (const auto player : {Player::kWhite, Player::kBlack}) {
+      const auto attacked = position.AttackedBy(player);
+      const auto king =
+          GetBitboardOfSquare(position.GetKingSquare(Flip(player)));
+      for (size_t index = 0; index < kBoardArea; ++index) {
+        const auto square = static_cast<BitIndex>(index);
+        const auto is_attacked =
+            (position.Attackers(square, king) & position.GetPieces(player))
+                .Any();
+        ASSERT_EQ(attacked.Test(square), is_attacked) << index;
+      }
+    }
+    position.UndoMove(move);
+  }
+}
+
+TEST_P(GenerateMovesTest, MovePicker) {
+  auto position = GetPosition();
+
+  for (const auto& move :
+       MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(position)) {
+    position.DoMove(move);
+
+    const auto moves =
+        MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(position);
+    std::vector<Move> expected(moves.begin(), moves.end());
+
+    // the last moves are used as the hash move and killers
+    MovePicker::Killers killers;
+    killers.Clear();
+    std::optional<Move> hash_move;
+    if (!expected.empty()) {
+      hash_move = expected.back();
+      killers.TryAdd(0, expected.front());
+      killers.TryAdd(0, expected[expected.size() / 2]);
+    }
+    const MovePicker::History history{};
+
+    std::vector<Move> picked;
+    MovePicker picker{position, hash_move, killers, 0, history};
+    while (const auto picked_move = picker.SelectNextMove()) {
+      picked.push_back(*picked_move);
+    }
+    if (hash_move) {
+      ASSERT_EQ(picked.front(), *hash_move);
+    }
+
+    const auto by_raw = [](const Move lhs, const Move rhs) {
+      return lhs.GetRaw() < rhs.GetRaw();
+    };
+    std::ranges::sort(expected, by_raw);
+    std::ranges::sort(picked, by_raw);
+    ASSERT_EQ(picked, expected);
+
+    position.UndoMove(move);
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(
     PerftTests, GenerateMovesTest,
     ::testing::Values(
@@ -486,6 +719,68 @@ TEST(GenerateMoves, ShannonNumberCheck) {
 }
 }  // namespace MoveGeneratorTests
 
+namespace TranspositionTableTests {
+TEST(ConcurrentAccess, NoTornEntries) {
+  // a single cluster, so that all threads fight for the same entries
+  TranspositionTable table{0};
+
+  // keys of the positions differ, so an entry matches only its own position
+  std::vector<Position> positions;
+  std::vector<uint16_t> keys;
+  auto position = PositionFactory{}();
+  for (const auto& move :
+       MoveGenerator{}.GenerateMoves<MoveGenerator::Type::kDefault>(position)) {
+    auto next = position;
+    next.DoMove(move);
+    const auto key = static_cast<uint16_t>(next.GetHash() >> 48);
+    if (std::ranges::find(keys, key) == keys.end()) {
+      keys.push_back(key);
+      positions.push_back(next);
+    }
+  }
+
+  // every field of an entry is derived from the whole hash of its position,
+  // so data paired with a stale key of another position is noticed
+  const auto get_entry = [](const Hash hash) {
+    return TranspositionTable::Entry{Move{}, static_cast<int16_t>(hash),
+                                     static_cast<int16_t>(hash >> 16),
+                                     static_cast<Depth>(hash >> 32 & 0x3F),
+                                     Bound::kExact};
+  };
+
+  constexpr size_t kThreads = 8;
+  constexpr size_t kIterations = 1'000'000;
+  std::atomic_size_t torn_entries = 0;
+
+  std::vector<std::thread> threads;
+  for (size_t thread = 0; thread < kThreads; ++thread) {
+    threads.emplace_back([&, thread] {
+      for (size_t i = 0; i < kIterations; ++i) {
+        const auto& pos = positions[(i * 7 + thread) % positions.size()];
+        const auto stored = get_entry(pos.GetHash());
+        table.SetEntry(pos, stored.move, stored.score, stored.depth,
+                       stored.bound, stored.static_eval);
+        const auto& probed_pos =
+            positions[(i * 13 + thread) % positions.size()];
+        if (const auto entry = table.Probe(probed_pos)) {
+          const auto expected = get_entry(probed_pos.GetHash());
+          if (entry->score != expected.score ||
+              entry->static_eval != expected.static_eval ||
+              entry->depth != expected.depth) {
+            ++torn_entries;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(torn_entries, 0);
+}
+}  // namespace TranspositionTableTests
+
 namespace ChessEngineTests {
 struct BestMoveTestCase {
   BestMoveTestCase(std::string fen, std::string best_move)
@@ -532,6 +827,7 @@ int main(int argc, char** argv) {
   SimpleChessEngine::InitBetween<SimpleChessEngine::Piece::kRook>();
   SimpleChessEngine::InitPawnAttacks();
   SimpleChessEngine::InitPSQT();
+  SimpleChessEngine::InitCuckoo();
 
   return RUN_ALL_TESTS();
 }
\ No newline at end of file